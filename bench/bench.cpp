@@ -0,0 +1,272 @@
+#include "synthetic_site.hpp"
+
+#include "util.hpp"
+#include "parser.hpp"
+#include "analyzer.hpp"
+#include "codegen.hpp"
+#include "context.hpp"
+#include "deploy.hpp"
+
+#include <libcpp/memory/arena.hpp>
+#include <libcpp/memory/array.hpp>
+#include <libcpp/util/defer.hpp>
+#include <libcpp/util/math.hpp>
+
+using namespace libcpp;
+
+#pragma warning(disable:4996) // crt secure
+#include "cstdio"
+#include "cstdlib"
+#include "cstring"
+
+#if defined(LIBCPP_MSVC)
+    #include <direct.h>
+    #define make_directory(path) _mkdir(path)
+#else
+    #include <sys/stat.h>
+    #define make_directory(path) mkdir(path, 0755)
+#endif
+
+
+enum Phase {
+    PHASE_READ_SOURCES,
+    PHASE_PARSE,
+    PHASE_ANALYZE,
+    PHASE_CODEGEN,
+    PHASE_DEPLOY,
+    PHASE_COUNT,
+};
+
+static const char *phase_names[PHASE_COUNT] = {
+    "read_sources",
+    "parse",
+    "analyze",
+    "codegen",
+    "deploy",
+};
+
+struct Phase_Result {
+    U64 total_ns;
+    U64 min_ns;
+
+    // NOTE(llw): context.arena and context.ast are never reset while
+    //  compiling, so their size at the end of a phase is also the peak.
+    Usize arena_used;
+    Usize arena_growth;
+};
+
+
+static bool parse_usize(const char *string, Usize &result) {
+    U64 value;
+    if(!parse_int_maybe(String { (U8 *)string, (Usize)strlen(string) }, value)) {
+        return false;
+    }
+
+    result = (Usize)value;
+    return true;
+}
+
+static void print_usage(const char *program) {
+    printf(
+        "Usage: %s [options]\n"
+        "    -pages n       concrete pages\n"
+        "    -depth n       inheritance depth of the page base chain\n"
+        "    -params n      extra parameters per base level\n"
+        "    -components n  shared widget/item definitions\n"
+        "    -lists n       lists per page\n"
+        "    -selects n     selects per page\n"
+        "    -nesting n     nested div levels per page\n"
+        "    -width n       children per div level\n"
+        "    -files n       source files\n"
+        "    -runs n        pipeline repetitions\n"
+        "    -threads n     parse threads, 0 is one per processor\n"
+        "    -d path        work directory (created)\n",
+        program
+    );
+}
+
+
+static bool compile_once(
+    const char *work_directory,
+    Usize file_count,
+    Usize thread_count,
+    Phase_Result *results,
+    Usize *expression_count
+) {
+    setup_context();
+    defer { destroy_context(); };
+
+    auto output_directory = create_array<U8>(context.temporary);
+    push(output_directory, String { (U8 *)work_directory, strlen(work_directory) });
+    push(output_directory, STRING("/out/"));
+    push(output_directory, (U8)0);
+
+    auto arguments = create_array<const char *>(context.temporary);
+    push(arguments, (const char *)"bench");
+    push(arguments, (const char *)"-i");
+    push(arguments, work_directory);
+    push(arguments, (const char *)"-o");
+    push(arguments, (const char *)output_directory.values);
+
+    for(Usize i = 0; i < file_count; i += 1) {
+        auto name = create_array<U8>(context.temporary);
+        push(name, STRING("site_"));
+        push_int(name, i);
+        push(name, STRING(".txt"));
+        push(name, (U8)0);
+        push(arguments, (const char *)name.values);
+    }
+
+    if(!parse_arguments((int)arguments.count, arguments.values)) {
+        return false;
+    }
+    context.thread_count = thread_count;
+
+    auto run_phase = [&](Phase phase, auto &&proc) {
+        auto arena_before = get_arena_bytes_used();
+        auto begin = get_time_ns();
+
+        auto ok = proc();
+
+        auto elapsed = get_time_ns() - begin;
+        auto &result = results[phase];
+        result.total_ns += elapsed;
+        result.min_ns = result.min_ns == 0 ? elapsed : min(result.min_ns, elapsed);
+        result.arena_used   = get_arena_bytes_used();
+        result.arena_growth = result.arena_used - arena_before;
+
+        return ok;
+    };
+
+    auto ok =
+           run_phase(PHASE_READ_SOURCES, [&]() { return read_sources(); })
+        && run_phase(PHASE_PARSE, [&]() { return parse_sources(); })
+        && run_phase(PHASE_ANALYZE, [&]() { return analyze(); })
+        && run_phase(PHASE_CODEGEN, [&]() { codegen(); return true; })
+        && run_phase(PHASE_DEPLOY,  [&]() { return deploy(); });
+
+    *expression_count = context.next_expression_id;
+    return ok;
+}
+
+
+int main(int argument_count, const char **arguments) {
+    auto config = default_synthetic_site_config();
+    auto run_count = (Usize)5;
+    auto thread_count = (Usize)0;
+    auto work_directory = "wsc-bench";
+
+    for(int i = 1; i < argument_count; i += 1) {
+        auto option = arguments[i];
+
+        if(strcmp(option, "-d") == 0 && i + 1 < argument_count) {
+            i += 1;
+            work_directory = arguments[i];
+            continue;
+        }
+
+        Usize *target = NULL;
+        if     (strcmp(option, "-pages")      == 0) { target = &config.page_count; }
+        else if(strcmp(option, "-depth")      == 0) { target = &config.inheritance_depth; }
+        else if(strcmp(option, "-params")     == 0) { target = &config.parameter_count; }
+        else if(strcmp(option, "-components") == 0) { target = &config.component_count; }
+        else if(strcmp(option, "-lists")      == 0) { target = &config.list_count; }
+        else if(strcmp(option, "-selects")    == 0) { target = &config.select_count; }
+        else if(strcmp(option, "-nesting")    == 0) { target = &config.body_depth; }
+        else if(strcmp(option, "-width")      == 0) { target = &config.body_width; }
+        else if(strcmp(option, "-files")      == 0) { target = &config.file_count; }
+        else if(strcmp(option, "-runs")       == 0) { target = &run_count; }
+        else if(strcmp(option, "-threads")    == 0) { target = &thread_count; }
+
+        i += 1;
+        if(target == NULL || i >= argument_count || !parse_usize(arguments[i], *target)) {
+            print_usage(arguments[0]);
+            return 1;
+        }
+    }
+
+    config.file_count = max(config.file_count, (Usize)1);
+    run_count = max(run_count, (Usize)1);
+
+
+    // NOTE(llw): Generate and write the corpus.
+    auto arena = create_arena();
+    defer { destroy(arena); };
+
+    auto files = create_array<Array<U8>>(arena);
+    generate_synthetic_site(config, files, arena);
+
+    make_directory(work_directory);
+    {
+        auto output_directory = create_array<U8>(arena);
+        push(output_directory, String { (U8 *)work_directory, strlen(work_directory) });
+        push(output_directory, STRING("/out"));
+        push(output_directory, (U8)0);
+        make_directory((const char *)output_directory.values);
+    }
+
+    auto source_bytes = (Usize)0;
+    auto number = create_array<U8>(arena);
+    for(Usize i = 0; i < files.count; i += 1) {
+        source_bytes += files[i].count;
+
+        auto path = create_array<U8>(arena);
+        push(path, String { (U8 *)work_directory, strlen(work_directory) });
+        push(path, STRING("/site_"));
+        serialize_int(i, number);
+        push(path, number);
+        push(path, STRING(".txt"));
+        push(path, (U8)0);
+
+        if(!write_entire_file((const char *)path.values, files[i])) {
+            printf("Error: Could not write '%s'.\n", (const char *)path.values);
+            return 1;
+        }
+    }
+
+    printf("corpus: %zu pages, depth %zu, %zu params, %zu components, "
+           "%zu lists, %zu selects, nesting %zu x %zu, %zu files, %zu bytes\n",
+        config.page_count, config.inheritance_depth, config.parameter_count,
+        config.component_count, config.list_count, config.select_count,
+        config.body_depth, config.body_width, config.file_count, source_bytes
+    );
+
+
+    // NOTE(llw): Run.
+    Phase_Result results[PHASE_COUNT] = {};
+    auto expression_count = (Usize)0;
+
+    for(Usize run = 0; run < run_count; run += 1) {
+        if(!compile_once(work_directory, files.count, thread_count, results, &expression_count)) {
+            printf("Error: Compilation failed in run %zu.\n", run);
+            return 1;
+        }
+    }
+
+    printf("runs: %zu, expressions: %zu\n\n", run_count, expression_count);
+    printf("%-14s %10s %10s %12s %14s %12s %12s\n",
+        "phase", "avg ms", "min ms", "MiB/s", "expr/s", "arena KiB", "growth KiB"
+    );
+
+    auto total_ns = (U64)0;
+    for(Usize i = 0; i < PHASE_COUNT; i += 1) {
+        const auto &result = results[i];
+        total_ns += result.total_ns;
+
+        auto average_s = (F64)result.total_ns / (F64)run_count / 1e9;
+        auto min_s     = (F64)result.min_ns / 1e9;
+
+        printf("%-14s %10.3f %10.3f %12.1f %14.0f %12zu %12zu\n",
+            phase_names[i],
+            average_s*1e3, min_s*1e3,
+            (F64)source_bytes/(F64)MEBI(1)/min_s,
+            (F64)expression_count/min_s,
+            result.arena_used/KIBI(1),
+            result.arena_growth/KIBI(1)
+        );
+    }
+
+    printf("%-14s %10.3f\n", "total", (F64)total_ns / (F64)run_count / 1e6);
+
+    return 0;
+}
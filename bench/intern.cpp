@@ -0,0 +1,88 @@
+#include "intern.hpp"
+
+#include <libcpp/memory/map.hpp>
+#include <libcpp/util/math.hpp>
+
+static_assert(
+    (Concurrent_String_Table::shard_count & (Concurrent_String_Table::shard_count - 1)) == 0,
+    "shard_count must be a power of two."
+);
+
+void init_concurrent_string_table(Concurrent_String_Table &table) {
+    table.previous_id = 0;
+
+    for(Usize i = 0; i < Concurrent_String_Table::shard_count; i += 1) {
+        auto &shard = table.shards[i];
+        init_mutex(shard.lock);
+        shard.arena = create_arena(default_allocator, KIBI(256));
+        shard.table = create_map<String, Interned_String>(shard.arena);
+    }
+
+    init_mutex(table.page_lock);
+    table.page_arena = create_arena(default_allocator, MEBI(1));
+    set_values(table.pages, (String *)NULL, Concurrent_String_Table::page_count);
+
+    // NOTE(llw): Id 0 is "no string", same as String_Table.
+    table.pages[0] = allocate_array<String>(Concurrent_String_Table::page_size, table.page_arena);
+}
+
+void destroy_concurrent_string_table(Concurrent_String_Table &table) {
+    for(Usize i = 0; i < Concurrent_String_Table::shard_count; i += 1) {
+        auto &shard = table.shards[i];
+        destroy_mutex(shard.lock);
+        destroy(shard.arena);
+    }
+
+    destroy_mutex(table.page_lock);
+    destroy(table.page_arena);
+}
+
+// NOTE(llw): The shard maps hash the whole string again, this only has to
+//  spread the strings. Mixes the size and up to 8 bytes from each end.
+static _inline Usize get_shard_index(String string) {
+    auto head = (U64)0;
+    auto tail = (U64)0;
+    auto size = min(string.size, (Usize)8);
+    copy_bytes(&head, string.values, size);
+    copy_bytes(&tail, string.values + string.size - size, size);
+
+    auto hash = (head ^ (tail*0x9e3779b97f4a7c15ULL) ^ string.size) * 0xff51afd7ed558ccdULL;
+    return (Usize)(hash >> 32) & (Concurrent_String_Table::shard_count - 1);
+}
+
+static void set_reverse(Concurrent_String_Table &table, Interned_String id, String string) {
+    auto page_index = id / Concurrent_String_Table::page_size;
+    assert(page_index < Concurrent_String_Table::page_count);
+
+    // NOTE(llw): Only new strings get here, so the lock is rarely taken.
+    LOCK_SCOPE(table.page_lock);
+
+    auto &page = table.pages[page_index];
+    if(page == NULL) {
+        page = allocate_array<String>(Concurrent_String_Table::page_size, table.page_arena);
+    }
+
+    page[id % Concurrent_String_Table::page_size] = string;
+}
+
+Interned_String intern(Concurrent_String_Table &table, String string) {
+    auto &shard = table.shards[get_shard_index(string)];
+
+    LOCK_SCOPE(shard.lock);
+
+    auto pointer = get_pointer(shard.table, string);
+    if(pointer != NULL) {
+        return *pointer;
+    }
+
+    auto id = atomic_add(&table.previous_id, 1) + 1;
+
+    auto s = allocate_array_uninitialized<U8>(string.size + 1, shard.arena);
+    copy_bytes(s, string.values, string.size);
+    s[string.size] = 0;
+    string.values = s;
+
+    insert(shard.table, string, id);
+    set_reverse(table, id, string);
+    return id;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "util.hpp"
+
+#include <libcpp/memory/arena.hpp>
+#include <libcpp/util/thread.hpp>
+
+// NOTE(llw): A String_Table that any number of threads can intern into. The
+//  strings are spread over shards by hash, each with its own lock, map and
+//  arena for the bytes, so threads only contend when they hit the same
+//  shard. Ids come from one atomic counter: they are unique and dense, but
+//  their order depends on scheduling. Use String_Table where the ids have to
+//  be deterministic, see merge_parse_job.
+struct Concurrent_String_Table {
+    static constexpr Usize shard_count = 64;
+
+    // NOTE(llw): The reverse lookup is split into pages, so it never moves
+    //  while other threads read from it.
+    static constexpr Usize page_size  = 4096;
+    static constexpr Usize page_count = 4096;
+
+    struct alignas(64) Shard {
+        Mutex lock;
+        Arena arena;
+        Map<String, Interned_String> table;
+    };
+
+    Shard shards[shard_count];
+    volatile U32 previous_id;
+
+    Mutex page_lock;
+    Arena page_arena;
+    String *pages[page_count];
+
+    String operator[](Interned_String id) const {
+        assert(id <= previous_id);
+        return pages[id / page_size][id % page_size];
+    }
+};
+
+// NOTE(llw): Initializes in place, the mutexes can't move. The table is
+//  large and its shards are cache line aligned, allocate it from an arena
+//  (malloc only guarantees 16 bytes).
+void init_concurrent_string_table(Concurrent_String_Table &table);
+void destroy_concurrent_string_table(Concurrent_String_Table &table);
+
+Interned_String intern(Concurrent_String_Table &table, String string);
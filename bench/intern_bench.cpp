@@ -0,0 +1,211 @@
+#include "util.hpp"
+#include "intern.hpp"
+
+#include <libcpp/memory/arena.hpp>
+#include <libcpp/memory/array.hpp>
+#include <libcpp/util/defer.hpp>
+#include <libcpp/util/math.hpp>
+#include <libcpp/util/thread.hpp>
+
+using namespace libcpp;
+
+#pragma warning(disable:4996) // crt secure
+#include "cstdio"
+#include "cstring"
+
+// NOTE(llw): Contended interning throughput. All threads intern slices of
+//  one skewed stream of strings into one shared table, like parse workers
+//  interning the atoms of their files would.
+
+enum Table_Kind {
+    TABLE_LOCKED,
+    TABLE_SHARDED,
+    TABLE_KIND_COUNT,
+};
+
+static const char *table_kind_names[TABLE_KIND_COUNT] = {
+    "string_table+mutex",
+    "sharded",
+};
+
+struct Shared_Tables {
+    Mutex lock;
+    String_Table locked;
+    Concurrent_String_Table *sharded;
+};
+
+struct Intern_Worker {
+    Thread thread;
+    Table_Kind kind;
+    Shared_Tables *tables;
+    const String *stream;
+    Usize begin;
+    Usize end;
+    U64 checksum;
+};
+
+static void intern_worker_proc(void *data) {
+    auto &worker = *(Intern_Worker *)data;
+    auto &tables = *worker.tables;
+
+    auto checksum = (U64)0;
+    for(Usize i = worker.begin; i < worker.end; i += 1) {
+        auto string = worker.stream[i];
+
+        auto id = (Interned_String)0;
+        if(worker.kind == TABLE_LOCKED) {
+            LOCK_SCOPE(tables.lock);
+            id = intern(tables.locked, string);
+        }
+        else {
+            id = intern(*tables.sharded, string);
+        }
+        checksum += id;
+    }
+    worker.checksum = checksum;
+}
+
+static U64 xorshift(U64 &state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static bool parse_usize(const char *string, Usize &result) {
+    U64 value;
+    if(!parse_int_maybe(String { (U8 *)string, (Usize)strlen(string) }, value)) {
+        return false;
+    }
+
+    result = (Usize)value;
+    return true;
+}
+
+static void print_usage(const char *program) {
+    printf(
+        "Usage: %s [options]\n"
+        "    -strings n     distinct strings\n"
+        "    -n n           strings interned per run\n"
+        "    -threads n     most threads, 0 is one per processor\n"
+        "    -runs n        repetitions, the fastest counts\n",
+        program
+    );
+}
+
+
+int main(int argument_count, const char **arguments) {
+    auto string_count = (Usize)16384;
+    auto stream_count = (Usize)4000000;
+    auto max_threads  = (Usize)0;
+    auto run_count    = (Usize)3;
+
+    for(int i = 1; i < argument_count; i += 1) {
+        auto option = arguments[i];
+
+        Usize *target = NULL;
+        if     (strcmp(option, "-strings") == 0) { target = &string_count; }
+        else if(strcmp(option, "-n")       == 0) { target = &stream_count; }
+        else if(strcmp(option, "-threads") == 0) { target = &max_threads; }
+        else if(strcmp(option, "-runs")    == 0) { target = &run_count; }
+
+        i += 1;
+        if(target == NULL || i >= argument_count || !parse_usize(arguments[i], *target)) {
+            print_usage(arguments[0]);
+            return 1;
+        }
+    }
+
+    string_count = max(string_count, (Usize)1);
+    run_count    = max(run_count, (Usize)1);
+    if(max_threads == 0) {
+        max_threads = get_processor_count();
+    }
+
+    auto arena = create_arena();
+    defer { destroy(arena); };
+
+    // NOTE(llw): Identifier like strings, 3 to 24 bytes.
+    auto strings = create_array<String>(arena);
+    auto state = (U64)0x9e3779b97f4a7c15ULL;
+    for(Usize i = 0; i < string_count; i += 1) {
+        auto buffer = create_array<U8>(arena);
+        auto size = 3 + xorshift(state) % 22;
+        for(Usize j = 0; j < size; j += 1) {
+            push(buffer, (U8)('a' + xorshift(state) % 26));
+        }
+
+        // NOTE(llw): Not push_int, it needs the context.
+        char number[32];
+        auto number_size = snprintf(number, sizeof(number), "_%zu", i);
+        push(buffer, String { (U8 *)number, (Usize)number_size });
+        push(strings, str(buffer));
+    }
+
+    // NOTE(llw): Skewed like source text: a few strings are most of the
+    //  uses.
+    auto stream = create_array<String>(arena);
+    reserve(stream, stream_count);
+    for(Usize i = 0; i < stream_count; i += 1) {
+        auto r = xorshift(state);
+        auto range = (r & 3) == 0 ? string_count : min(string_count, (Usize)64);
+        push(stream, strings[(r >> 8) % range]);
+    }
+
+    printf("strings: %zu, stream: %zu, runs: %zu\n\n", string_count, stream_count, run_count);
+    printf("%-20s %8s %10s %12s\n", "table", "threads", "min ms", "M/s");
+
+    auto workers = allocate_array<Intern_Worker>(max_threads, arena);
+
+    for(Usize kind = 0; kind < TABLE_KIND_COUNT; kind += 1) {
+        for(Usize thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+            auto best_ns = (U64)0;
+
+            for(Usize run = 0; run < run_count; run += 1) {
+                auto table_arena = create_arena();
+
+                auto tables = Shared_Tables {};
+                init_mutex(tables.lock);
+                tables.locked = create_string_table(table_arena);
+                tables.sharded = allocate_uninitialized<Concurrent_String_Table>(table_arena);
+                init_concurrent_string_table(*tables.sharded);
+
+                for(Usize i = 0; i < thread_count; i += 1) {
+                    auto &worker = workers[i];
+                    worker = {};
+                    worker.kind   = (Table_Kind)kind;
+                    worker.tables = &tables;
+                    worker.stream = stream.values;
+                    worker.begin  = stream_count*i/thread_count;
+                    worker.end    = stream_count*(i + 1)/thread_count;
+                }
+
+                auto begin = get_time_ns();
+                for(Usize i = 1; i < thread_count; i += 1) {
+                    auto created = create_thread(workers[i].thread, intern_worker_proc, &workers[i]);
+                    assert(created);
+                    UNUSED(created);
+                }
+                intern_worker_proc(&workers[0]);
+                for(Usize i = 1; i < thread_count; i += 1) {
+                    join_thread(workers[i].thread);
+                }
+                auto elapsed = get_time_ns() - begin;
+
+                best_ns = best_ns == 0 ? elapsed : min(best_ns, elapsed);
+
+                destroy_concurrent_string_table(*tables.sharded);
+                destroy_mutex(tables.lock);
+                destroy(table_arena);
+            }
+
+            printf("%-20s %8zu %10.3f %12.1f\n",
+                table_kind_names[kind], thread_count,
+                (F64)best_ns/1e6,
+                (F64)stream_count/((F64)best_ns/1e9)/1e6
+            );
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,328 @@
+#include "synthetic_site.hpp"
+
+#include <libcpp/util/math.hpp>
+
+
+Synthetic_Site_Config default_synthetic_site_config() {
+    auto result = Synthetic_Site_Config {};
+    result.page_count        = 1000;
+    result.inheritance_depth = 4;
+    result.parameter_count   = 2;
+    result.component_count   = 8;
+    result.list_count        = 1;
+    result.select_count      = 1;
+    result.body_depth        = 3;
+    result.body_width        = 3;
+    result.file_count        = 1;
+    return result;
+}
+
+
+struct Site_Writer {
+    const Synthetic_Site_Config *config;
+    Array<U8> *buffer;
+    Array<U8> number;
+    Usize indent;
+    Usize next_id;
+};
+
+static void write(Site_Writer &writer, String string) {
+    push(*writer.buffer, string);
+}
+
+static void write(Site_Writer &writer, Usize value) {
+    serialize_int(value, writer.number);
+    push(*writer.buffer, writer.number);
+}
+
+static void write_line(Site_Writer &writer, String string) {
+    for(Usize i = 0; i < writer.indent; i += 1) {
+        push(*writer.buffer, STRING("    "));
+    }
+    write(writer, string);
+}
+
+static void write_name(Site_Writer &writer, String prefix, Usize index) {
+    write(writer, prefix);
+    write(writer, index);
+}
+
+static void write_quoted_name(Site_Writer &writer, String prefix, Usize index) {
+    write(writer, STRING("\""));
+    write_name(writer, prefix, index);
+    write(writer, STRING("\""));
+}
+
+static void write_slot_name(Site_Writer &writer, Usize level, Usize slot) {
+    write_name(writer, STRING("slot_"), level);
+    write_name(writer, STRING("_"), slot);
+}
+
+static void write_parameters(Site_Writer &writer, Usize level) {
+    write_line(writer, STRING("parameters: [ content"));
+    for(Usize i = 0; i < writer.config->parameter_count; i += 1) {
+        write(writer, STRING(", "));
+        write_slot_name(writer, level, i);
+    }
+    write(writer, STRING(" ]\n"));
+}
+
+
+static void write_body(Site_Writer &writer, Usize level) {
+    const auto &config = *writer.config;
+
+    for(Usize i = 0; i < config.body_width; i += 1) {
+        if(level < config.body_depth) {
+            writer.next_id += 1;
+
+            write_line(writer, STRING("div id: "));
+            write_quoted_name(writer, STRING("n"), writer.next_id);
+            write(writer, STRING(", classes: [ "));
+            write_quoted_name(writer, STRING("level_"), level);
+            write(writer, STRING(" ], body: {\n"));
+
+            writer.indent += 1;
+            write_body(writer, level + 1);
+            writer.indent -= 1;
+
+            write_line(writer, STRING("}\n"));
+        }
+        else if(i % 2 == 0) {
+            write_line(writer, STRING("p body: { \"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor.\" }\n"));
+        }
+        else {
+            write_line(writer, STRING("\"Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris.\"\n"));
+        }
+    }
+}
+
+static void write_page_content(Site_Writer &writer, Usize page) {
+    const auto &config = *writer.config;
+
+    writer.next_id = 0;
+
+    write_body(writer, 0);
+
+    if(config.component_count > 0) {
+        write_line(writer, STRING("div inherits: "));
+        write_quoted_name(writer, STRING("widget_"), page % config.component_count);
+        write(writer, STRING(", slot: { \"Widget content\" }\n"));
+    }
+
+    if(config.list_count + config.select_count > 0) {
+        write_line(writer, STRING("form id: \"form\", body: {\n"));
+        writer.indent += 1;
+
+        for(Usize i = 0; i < config.list_count; i += 1) {
+            write_line(writer, STRING("list id: "));
+            write_quoted_name(writer, STRING("list_"), i);
+            if(config.component_count > 0) {
+                write(writer, STRING(", type: "));
+                write_quoted_name(writer, STRING("item_"), (page + i) % config.component_count);
+            }
+            else {
+                write(writer, STRING(", type: \"item\""));
+            }
+            write(writer, STRING(", initial: 2, min: 0, max: 16\n"));
+        }
+
+        for(Usize i = 0; i < config.select_count; i += 1) {
+            write_line(writer, STRING("(select\n"));
+            writer.indent += 1;
+            write_line(writer, STRING("id: "));
+            write_quoted_name(writer, STRING("select_"), i);
+            write(writer, STRING("\n"));
+            write_line(writer, STRING("required: 1\n"));
+            write_line(writer, STRING("options: {\n"));
+            writer.indent += 1;
+            write_line(writer, STRING("option text: \"First\", value: \"first\"\n"));
+            write_line(writer, STRING("option text: \"Second\", value: \"second\"\n"));
+            write_line(writer, STRING("option text: \"Third\"\n"));
+            writer.indent -= 1;
+            write_line(writer, STRING("}\n"));
+            writer.indent -= 1;
+            write_line(writer, STRING(")\n"));
+        }
+
+        writer.indent -= 1;
+        write_line(writer, STRING("}\n"));
+    }
+}
+
+
+static void write_item(Site_Writer &writer, bool indexed, Usize index) {
+    write(writer, STRING("(div\n"));
+    write(writer, STRING("    defines: "));
+    if(indexed) {
+        write_quoted_name(writer, STRING("item_"), index);
+    }
+    else {
+        write(writer, STRING("\"item\""));
+    }
+    write(writer, STRING("\n"));
+    write(writer, STRING("    body: {\n"));
+    write(writer, STRING("        (label for: \"name\", body: { \"Name\" })\n"));
+    write(writer, STRING("        input id: \"name\", type: \"text\", min_length: 1, max_length: 64\n"));
+    write(writer, STRING("        (label for: \"amount\", body: { \"Amount\" })\n"));
+    write(writer, STRING("        input id: \"amount\", type: \"number\", initial: 1\n"));
+    write(writer, STRING("    }\n"));
+    write(writer, STRING(")\n\n"));
+}
+
+static void write_shared_definitions(Site_Writer &writer) {
+    const auto &config = *writer.config;
+
+    // NOTE(llw): Base chain. Every level fills the slots of the one below
+    //  and forwards "content".
+    for(Usize level = 0; level < config.inheritance_depth; level += 1) {
+        write(writer, STRING("// Base level "));
+        write(writer, level);
+        write(writer, STRING(".\n(page\n"));
+        writer.indent = 1;
+
+        write_line(writer, STRING("defines: "));
+        write_quoted_name(writer, STRING("base_"), level);
+        write(writer, STRING("\n"));
+
+        write_parameters(writer, level);
+
+        if(level == 0) {
+            write_line(writer, STRING("title: \"Synthetic\"\n"));
+            write_line(writer, STRING("body: {\n"));
+            write_line(writer, STRING("    div id: \"frame\", classes: [ \"frame\" ], body: { content }\n"));
+            for(Usize i = 0; i < config.parameter_count; i += 1) {
+                write_line(writer, STRING("    "));
+                write_slot_name(writer, level, i);
+                write(writer, STRING("\n"));
+            }
+            write_line(writer, STRING("}\n"));
+        }
+        else {
+            write_line(writer, STRING("inherits: "));
+            write_quoted_name(writer, STRING("base_"), level - 1);
+            write(writer, STRING("\n"));
+
+            write_line(writer, STRING("content: {\n"));
+            write_line(writer, STRING("    h1 body: { \"Level "));
+            write(writer, level);
+            write(writer, STRING("\" }\n"));
+            write_line(writer, STRING("    content\n"));
+            write_line(writer, STRING("}\n"));
+
+            for(Usize i = 0; i < config.parameter_count; i += 1) {
+                write_line(writer, STRING(""));
+                write_slot_name(writer, level - 1, i);
+                write(writer, STRING(": { span body: { \"Slot\" } "));
+                write_slot_name(writer, level, i);
+                write(writer, STRING(" }\n"));
+            }
+        }
+
+        writer.indent = 0;
+        write(writer, STRING(")\n\n"));
+    }
+
+    // NOTE(llw): Components.
+    for(Usize i = 0; i < config.component_count; i += 1) {
+        write(writer, STRING("(div\n"));
+        write(writer, STRING("    defines: "));
+        write_quoted_name(writer, STRING("widget_"), i);
+        write(writer, STRING("\n"));
+        write(writer, STRING("    parameters: [ slot ]\n"));
+        write(writer, STRING("    classes: [ \"widget\", "));
+        write_quoted_name(writer, STRING("widget_"), i);
+        write(writer, STRING(" ]\n"));
+        write(writer, STRING("    body: {\n"));
+        write(writer, STRING("        h1 body: { \"Widget\" }\n"));
+        write(writer, STRING("        slot\n"));
+        write(writer, STRING("    }\n"));
+        write(writer, STRING(")\n\n"));
+    }
+
+    if(config.list_count > 0) {
+        if(config.component_count > 0) {
+            for(Usize i = 0; i < config.component_count; i += 1) {
+                write_item(writer, true, i);
+            }
+        }
+        else {
+            write_item(writer, false, 0);
+        }
+    }
+}
+
+static void write_page(Site_Writer &writer, Usize page) {
+    const auto &config = *writer.config;
+
+    write(writer, STRING("(page\n"));
+    writer.indent = 1;
+
+    write_line(writer, STRING("defines: "));
+    write_quoted_name(writer, STRING("page_"), page);
+    write(writer, STRING("\n"));
+
+    if(config.inheritance_depth > 0) {
+        auto top = config.inheritance_depth - 1;
+
+        write_line(writer, STRING("inherits: "));
+        write_quoted_name(writer, STRING("base_"), top);
+        write(writer, STRING("\n"));
+
+        write_line(writer, STRING("content: {\n"));
+        writer.indent += 1;
+        write_page_content(writer, page);
+        writer.indent -= 1;
+        write_line(writer, STRING("}\n"));
+
+        for(Usize i = 0; i < config.parameter_count; i += 1) {
+            write_line(writer, STRING(""));
+            write_slot_name(writer, top, i);
+            write(writer, STRING(": { \"Page slot\" }\n"));
+        }
+    }
+    else {
+        write_line(writer, STRING("title: "));
+        write_quoted_name(writer, STRING("Page "), page);
+        write(writer, STRING("\n"));
+
+        write_line(writer, STRING("body: {\n"));
+        writer.indent += 1;
+        write_page_content(writer, page);
+        writer.indent -= 1;
+        write_line(writer, STRING("}\n"));
+    }
+
+    writer.indent = 0;
+    write(writer, STRING(")\n\n"));
+}
+
+
+void generate_synthetic_site(
+    const Synthetic_Site_Config &config,
+    Array<Array<U8>> &files,
+    Allocator &allocator
+) {
+    auto file_count = max(config.file_count, (Usize)1);
+    auto first_file = files.count;
+
+    for(Usize i = 0; i < file_count; i += 1) {
+        push(files, create_array<U8>(allocator));
+    }
+
+    auto writer = Site_Writer {};
+    writer.config = &config;
+    writer.number = create_array<U8>(allocator);
+
+    writer.buffer = &files[first_file];
+    write_shared_definitions(writer);
+
+    for(Usize i = 0; i < config.page_count; i += 1) {
+        auto file = (Usize)0;
+        if(file_count > 1) {
+            file = 1 + i % (file_count - 1);
+        }
+
+        writer.buffer = &files[first_file + file];
+        write_page(writer, i);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "util.hpp"
+
+struct Synthetic_Site_Config {
+    // NOTE(llw): Number of concrete pages.
+    Usize page_count;
+
+    // NOTE(llw): Length of the "base_*" page chain every page inherits from.
+    //  0 makes pages concrete.
+    Usize inheritance_depth;
+
+    // NOTE(llw): Extra parameters on every level of the base chain (on top
+    //  of "content").
+    Usize parameter_count;
+
+    // NOTE(llw): Shared "widget_*" and "item_*" div definitions.
+    Usize component_count;
+
+    // NOTE(llw): Lists and selects per page.
+    Usize list_count;
+    Usize select_count;
+
+    // NOTE(llw): Nested div levels below "content" and children per level.
+    Usize body_depth;
+    Usize body_width;
+
+    // NOTE(llw): Pages are spread round robin over file_count - 1 files,
+    //  file 0 holds the shared definitions.
+    Usize file_count;
+};
+
+Synthetic_Site_Config default_synthetic_site_config();
+
+// NOTE(llw): Appends one buffer per file to files.
+void generate_synthetic_site(
+    const Synthetic_Site_Config &config,
+    Array<Array<U8>> &files,
+    Allocator &allocator
+);
@@ -36,22 +36,40 @@ set libcpp_sources=^
     %libcpp_root%\libcpp\memory\arena.cpp^
     %libcpp_root%\libcpp\memory\hash.cpp^
     %libcpp_root%\libcpp\memory\heap.cpp^
+    %libcpp_root%\libcpp\memory\tracking.cpp^
+    %libcpp_root%\libcpp\memory\virtual_memory_win32.cpp^
     %libcpp_root%\libcpp\util\assert.cpp^
-    %libcpp_root%\libcpp\util\assert_win32.cpp
+    %libcpp_root%\libcpp\util\assert_win32.cpp^
+    %libcpp_root%\libcpp\util\thread_win32.cpp
 
 set libcpp=/I%libcpp_root%
 
 set sources=^
-    ..\code\main.cpp^
     ..\code\util.cpp^
     ..\code\parser.cpp^
     ..\code\context.cpp^
     ..\code\analyzer.cpp^
     ..\code\codegen.cpp^
-    ..\code\deploy.cpp
+    ..\code\deploy.cpp^
+    ..\code\stats.cpp^
+    ..\code\trace.cpp^
+    ..\code\scan.cpp^
+    ..\code\ast_cache.cpp
 
 set all_sources=%sources% %libcpp_sources%
 
-cl %all_sources% User32.lib /I..\code %libcpp% %compile_flags_debug% /link %link_flags% /out:main.exe
+cl ..\code\main.cpp %all_sources% User32.lib /I..\code %libcpp% %compile_flags_debug% /link %link_flags% /out:main.exe
+
+set bench_sources=^
+    ..\bench\bench.cpp^
+    ..\bench\synthetic_site.cpp
+
+cl %bench_sources% %all_sources% User32.lib /I..\code %libcpp% %compile_flags_release% /link %link_flags% /out:bench.exe
+
+set intern_bench_sources=^
+    ..\bench\intern_bench.cpp^
+    ..\bench\intern.cpp
+
+cl %intern_bench_sources% %all_sources% User32.lib /I..\code %libcpp% %compile_flags_release% /link %link_flags% /out:intern_bench.exe
 
 popd
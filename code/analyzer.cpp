@@ -2,6 +2,7 @@
 #include "context.hpp"
 
 #include "stdio.h"
+#include <stdarg.h>
 #include <limits>
 
 _inline bool is_definition(const Expression &expr) {
@@ -40,7 +41,48 @@ _inline bool is_identifier(String string) {
 }
 
 
+// NOTE(llw): The state of one thread that validates, see validate_symbols.
+struct Validator {
+    // NOTE(llw): Holds the id tables and the error.
+    Arena *arena;
+    Arena *temporary;
+
+    // NOTE(llw): Full ids are only compared with each other, so threads
+    //  intern them into their own table.
+    String_Table *ids;
+
+    // NOTE(llw): Of the first failure, printed by the caller.
+    const char *error;
+};
+
+static Validator make_validator(Arena &arena, Arena &temporary, String_Table &ids) {
+    auto validator = Validator {};
+    validator.arena = &arena;
+    validator.temporary = &temporary;
+    validator.ids = &ids;
+    return validator;
+}
+
+static bool validate_error(Validator &validator, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    auto size = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+
+    auto message = allocate_array_uninitialized<char>((Usize)size + 1, *validator.arena);
+    vsnprintf(message, (Usize)size + 1, format, args);
+    va_end(args);
+
+    validator.error = message;
+    return false;
+}
+
+
 struct Validate_Context {
+    Validator *validator;
+
     Map<Interned_String, int> *id_table;
     Array<Interned_String>    *label_fors;
 
@@ -48,11 +90,14 @@ struct Validate_Context {
     bool in_form;
 };
 
-static bool validate(Symbol &symbol);
-static Expression *instantiate(const Expression &expr);
+static bool validate(Validator &validator, const Symbol &symbol);
+static bool validate_symbols();
+static bool instantiate_exports();
 
 
 bool analyze() {
+    STATS_TIME_SCOPE(TIME_ANALYZE);
+    STATS_MEMORY_SCOPE(MEMORY_ANALYZE);
 
     // NOTE(llw): Fill symbol table.
     for(Usize i = 0; i < context.expressions.count; i += 1) {
@@ -74,6 +119,7 @@ bool analyze() {
 
         auto symbol = Symbol {};
         symbol.expression = &expr;
+        symbol.index = (U32)context.symbols.count;
         if(!insert_maybe(context.symbols, defines->value, symbol)) {
             printf("Multiple definitions.\n");
             return false;
@@ -81,29 +127,16 @@ bool analyze() {
     }
 
     // NOTE(llw): Validate.
-    for(Usize i = 0; i < context.symbols.count; i += 1) {
-        if(!validate(context.symbols.entries[i].value)) {
+    {
+        STATS_TIME_SCOPE(TIME_VALIDATE);
+        if(!validate_symbols()) {
             return false;
         }
     }
 
     // NOTE(llw): Instantiate non-generic symbols.
-    for(Usize i = 0; i < context.symbols.count; i += 1) {
-
-        auto &symbol = context.symbols.entries[i].value;
-        if(is_generic(*symbol.expression)) {
-            continue;
-        }
-
-        auto instance = instantiate(*symbol.expression);
-        if(instance == NULL) {
-            return false;
-        }
-
-        push(context.exports, instance);
-    }
-
-    return true;
+    STATS_TIME_SCOPE(TIME_INSTANTIATE);
+    return instantiate_exports();
 }
 
 
@@ -118,7 +151,7 @@ static bool is_list_of(
     if(arg.type == ARG_LIST) {
         valid = true;
 
-        const auto &list = arg.list;
+        auto list = get_list(arg);
         for(Usize i = 0; i < list.count; i += 1) {
             auto item = list[i];
 
@@ -138,12 +171,13 @@ static bool is_list_of(
 
 
 static bool validate(const Expression &expr, Validate_Context vc) {
+    auto &temporary = *vc.validator->temporary;
 
-    TEMP_SCOPE(context.temporary);
+    TEMP_SCOPE(temporary);
 
     const auto &args = expr.arguments;
 
-    auto used_args = create_map<Interned_String, int>(context.temporary);
+    auto used_args = create_map<Interned_String, int>(temporary);
     auto use_arg = [&](Interned_String arg) {
         insert_maybe(used_args, arg, 0);
     };
@@ -158,20 +192,18 @@ static bool validate(const Expression &expr, Validate_Context vc) {
 
         if(arg == NULL) {
             if(required) {
-                printf("Error: Missing required argument '%s'.\n",
+                return validate_error(*vc.validator, "Error: Missing required argument '%s'.",
                     context.string_table[name].values
                 );
-                return false;
             }
             return true;
         }
 
         if(arg->type != type) {
-            printf("Error: '%s' must be a %s\n",
+            return validate_error(*vc.validator, "Error: '%s' must be a %s",
                 context.string_table[name].values,
                 argument_type_strings[type]
             );
-            return false;
         }
 
         return true;
@@ -191,20 +223,18 @@ static bool validate(const Expression &expr, Validate_Context vc) {
 
         if(arg == NULL) {
             if(required) {
-                printf("Error: Missing required argument '%s'.\n",
+                return validate_error(*vc.validator, "Error: Missing required argument '%s'.",
                     context.string_table[name].values
                 );
-                return false;
             }
             return true;
         }
 
         if(!is_list_of(*arg, type, NULL)) {
-            printf("Error: Non-%s argument in list '%s'.\n",
+            return validate_error(*vc.validator, "Error: Non-%s argument in list '%s'.",
                 argument_type_strings[type],
                 context.string_table[name].values
             );
-            return false;
         }
 
         return true;
@@ -222,9 +252,8 @@ static bool validate(const Expression &expr, Validate_Context vc) {
         }
 
         if(required != NULL) {
-            if(parse_int(context.string_table[required->value]) != 1) {
-                printf("Error: 'required' must be 1.\n");
-                return false;
+            if(required->number != 1) {
+                return validate_error(*vc.validator, "Error: 'required' must be 1.");
             }
         }
 
@@ -281,8 +310,7 @@ static bool validate(const Expression &expr, Validate_Context vc) {
             && classes  == NULL
             && styles   == NULL
         ) {
-            printf("Error: Empty div.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: Empty div.");
         }
 
     }
@@ -293,8 +321,7 @@ static bool validate(const Expression &expr, Validate_Context vc) {
 
         if(expr.type == context.strings.form) {
             if(vc.in_form) {
-                printf("Error: Forms cannot be nested.\n");
-                return false;
+                return validate_error(*vc.validator, "Error: Forms cannot be nested.");
             }
             vc.in_form = true;
         }
@@ -306,8 +333,7 @@ static bool validate(const Expression &expr, Validate_Context vc) {
             && classes  == NULL
             && styles   == NULL
         ) {
-            printf("Error: Empty form.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: Empty form.");
         }
 
     }
@@ -335,20 +361,17 @@ static bool validate(const Expression &expr, Validate_Context vc) {
             // NOTE(llw): Existence.
             auto symbol = get_pointer(context.symbols, type->value);
             if(symbol == NULL) {
-                printf("Error: Referenced symbol does not exist.\n");
-                return false;
+                return validate_error(*vc.validator, "Error: Referenced symbol does not exist.");
             }
 
             // NOTE(llw): Type.
             if(symbol->expression->type == context.strings.page) {
-                printf("Error: List type cannot be a page..\n");
-                return false;
+                return validate_error(*vc.validator, "Error: List type cannot be a page..");
             }
 
             // NOTE(llw): Concrete.
             if(!is_concrete(*symbol->expression)) {
-                printf("Error: List type must be concrete.\n");
-                return false;
+                return validate_error(*vc.validator, "Error: List type must be concrete.");
             }
 
 
@@ -358,18 +381,17 @@ static bool validate(const Expression &expr, Validate_Context vc) {
             F64 max_val     = +std::numeric_limits<F64>::infinity();
 
             if(initial != NULL) {
-                initial_val = (F64)parse_int(context.string_table[initial->value]);
+                initial_val = (F64)initial->number;
             }
             if(min != NULL) {
-                min_val = (F64)parse_int(context.string_table[min->value]);
+                min_val = (F64)min->number;
             }
             if(max != NULL) {
-                max_val = (F64)parse_int(context.string_table[max->value]);
+                max_val = (F64)max->number;
             }
 
             if(initial_val < min_val || initial_val > max_val) {
-                printf("Error: List initial out of bounds.\n");
-                return false;
+                return validate_error(*vc.validator, "Error: List initial out of bounds.");
             }
         }
         else {
@@ -390,27 +412,24 @@ static bool validate(const Expression &expr, Validate_Context vc) {
                 return false;
             }
 
-            const auto &block = options->block;
+            auto block = get_block(*options);
             for(Usize i = 0; i < block.count; i += 1) {
                 const auto &option = block[i];
                 const auto &args = option.arguments;
 
                 if(option.type != context.strings.option) {
-                    printf("Error: Not an option.\n");
-                    return false;
+                    return validate_error(*vc.validator, "Error: Not an option.");
                 }
 
                 auto value = get_pointer(args, context.strings.value);
                 if(value != NULL && value->type != ARG_STRING) {
-                    printf("Error: Option value must be a string.\n");
-                    return false;
+                    return validate_error(*vc.validator, "Error: Option value must be a string.");
                 }
 
                 // NOTE(llw): text is required.
                 auto text = get_pointer(args, context.strings.text);
                 if(text == NULL || text->type != ARG_STRING) {
-                    printf("Error: Option text must be a string.\n");
-                    return false;
+                    return validate_error(*vc.validator, "Error: Option text must be a string.");
                 }
             }
 
@@ -434,7 +453,9 @@ static bool validate(const Expression &expr, Validate_Context vc) {
         }
 
         if(_for != NULL && vc.id_prefix != 0) {
-            auto referenced = make_full_id(vc.id_prefix, _for->value);
+            Id_Type id_type;
+            auto ident = get_id_identifier(_for->value, &id_type);
+            auto referenced = make_full_id(*vc.validator->ids, temporary, vc.id_prefix, ident, id_type);
             push(*vc.label_fors, referenced);
         }
     }
@@ -481,10 +502,8 @@ static bool validate(const Expression &expr, Validate_Context vc) {
                 }
 
                 if(initial != NULL) {
-                    auto value = context.string_table[initial->value];
-                    if(!eq(value, STRING("0")) && !eq(value, STRING("1"))) {
-                        printf("Error: Checkbox initial must be 0 or 1.\n");
-                        return false;
+                    if(initial->number > 1) {
+                        return validate_error(*vc.validator, "Error: Checkbox initial must be 0 or 1.");
                     }
                 }
             }
@@ -492,8 +511,7 @@ static bool validate(const Expression &expr, Validate_Context vc) {
                 // ok.
             }
             else {
-                printf("Invalid input type.\n");
-                return false;
+                return validate_error(*vc.validator, "Invalid input type.");
             }
 
             // NOTE(llw): validation options.
@@ -513,11 +531,8 @@ static bool validate(const Expression &expr, Validate_Context vc) {
                 }
 
                 if(min_length != NULL && max_length != NULL) {
-                    if(   parse_int(context.string_table[min_length->value])
-                        > parse_int(context.string_table[max_length->value])
-                    ) {
-                        printf("Error: 'min_length' must not be greater than 'max_length'.\n");
-                        return false;
+                    if(min_length->number > max_length->number) {
+                        return validate_error(*vc.validator, "Error: 'min_length' must not be greater than 'max_length'.");
                     }
                 }
             }
@@ -537,8 +552,7 @@ static bool validate(const Expression &expr, Validate_Context vc) {
     // NOTE(llw): text.
     else if(expr.type == context.strings.text) {
         if(classes != NULL || styles != NULL) {
-            printf("Error: Text does not support css.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: Text does not support css.");
         }
 
         if(!validate_arg_type(context.strings.value, ARG_STRING, true)) {
@@ -562,17 +576,14 @@ static bool validate(const Expression &expr, Validate_Context vc) {
     // NOTE(llw): Unknown.
     else {
         auto type = context.string_table[expr.type];
-        printf("Unrecognized expression type: '%s'\n", type.values);
-
-        return false;
+        return validate_error(*vc.validator, "Unrecognized expression type: '%s'", type.values);
     }
 
 
     // NOTE(llw): Definitions.
     if(definition) {
         if(expr.parent != NULL) {
-            printf("Error: Definitions cannot be nested.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: Definitions cannot be nested.");
         }
     }
 
@@ -581,8 +592,7 @@ static bool validate(const Expression &expr, Validate_Context vc) {
     auto full_id = Interned_String {};
     if(id != NULL) {
         if(!supports_id) {
-            printf("Error: Id not supported.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: Id not supported.");
         }
 
         use_arg(context.strings.id);
@@ -590,29 +600,25 @@ static bool validate(const Expression &expr, Validate_Context vc) {
         if(    id->type != ARG_STRING
             || id->value == context.strings.empty_string
         ) {
-            printf("Error: ids must be non-empty strings.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: ids must be non-empty strings.");
         }
 
         Id_Type id_type;
         auto ident = get_id_identifier(id->value, &id_type);
         if(!is_identifier(ident)) {
-            printf("Error: ids must be identifiers.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: ids must be identifiers.");
         }
 
         if(definition && id_type != ID_LOCAL) {
-            printf("Error: ids on definitions must be local.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: ids on definitions must be local.");
         }
 
         // NOTE(llw): Check id uniqueness.
         if(vc.id_prefix != 0) {
-            full_id = make_full_id(vc.id_prefix, ident, id_type);
+            full_id = make_full_id(*vc.validator->ids, temporary, vc.id_prefix, ident, id_type);
 
             if(!insert_maybe(*vc.id_table, full_id, 0)) {
-                printf("Error: Duplicate id.\n");
-                return false;
+                return validate_error(*vc.validator, "Error: Duplicate id.");
             }
 
             if(id_type == ID_LOCAL) {
@@ -622,39 +628,34 @@ static bool validate(const Expression &expr, Validate_Context vc) {
 
     }
     else if(requires_id) {
-        printf("Error: Id required.\n");
-        return false;
+        return validate_error(*vc.validator, "Error: Id required.");
     }
 
     // NOTE(llw): Validate parameters.
     if(parameters != NULL) {
 
         if(defines == NULL) {
-            printf("Error: Parameter lists only allowed on definitions.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: Parameter lists only allowed on definitions.");
         }
 
         if(parameters->type != ARG_LIST) {
-            printf("Error: Parameters must be a list.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: Parameters must be a list.");
         }
 
-        TEMP_SCOPE(context.temporary);
-        auto names = create_map<Interned_String, int>(context.temporary);
+        TEMP_SCOPE(temporary);
+        auto names = create_map<Interned_String, int>(temporary);
 
         // NOTE(llw): Unique atoms.
-        const auto &list = parameters->list;
+        auto list = get_list(*parameters);
         for(Usize i = 0; i < list.count; i += 1) {
             const auto &name = list[i];
 
             if(name.type != ARG_ATOM) {
-                printf("Error: Parameter list must only contain atoms.\n");
-                return false;
+                return validate_error(*vc.validator, "Error: Parameter list must only contain atoms.");
             }
 
             if(!insert_maybe(names, name.value, 0)) {
-                printf("Error: Parameter declared multiple times.\n");
-                return false;
+                return validate_error(*vc.validator, "Error: Parameter declared multiple times.");
             }
         }
 
@@ -663,19 +664,17 @@ static bool validate(const Expression &expr, Validate_Context vc) {
     // NOTE(llw): Validate body.
     if(body != NULL) {
         if(!supports_body) {
-            printf("Error: Body not supported.\n");
-            return false;
+            return validate_error(*vc.validator, "Error: Body not supported.");
         }
 
         use_arg(context.strings.body);
 
         if(concrete) {
             if(body->type != ARG_BLOCK) {
-                printf("Error: Body must be a block.\n");
-                return false;
+                return validate_error(*vc.validator, "Error: Body must be a block.");
             }
 
-            const auto &block = body->block;
+            auto block = get_block(*body);
             for(Usize i = 0; i < block.count; i += 1) {
                 if(!validate(block[i], vc)) {
                     return false;
@@ -684,8 +683,7 @@ static bool validate(const Expression &expr, Validate_Context vc) {
         }
     }
     else if(requires_body) {
-        printf("Error: Body required.\n");
-        return false;
+        return validate_error(*vc.validator, "Error: Body required.");
     }
 
 
@@ -700,12 +698,11 @@ static bool validate(const Expression &expr, Validate_Context vc) {
     // NOTE(llw): Unused arguments.
     if(concrete) {
         for(Usize i = 0; i < args.count; i += 1) {
-            auto name = args.entries[i].key;
+            auto name = get_key(args, i);
 
             if(!has(used_args, name)) {
                 auto string = context.string_table[name];
-                printf("Error: Unused argument '%s'\n", string.values);
-                return false;
+                return validate_error(*vc.validator, "Error: Unused argument '%s'", string.values);
             }
         }
     }
@@ -714,20 +711,19 @@ static bool validate(const Expression &expr, Validate_Context vc) {
 }
 
 
-static bool validate(Symbol &symbol) {
+static bool validate(Validator &validator, const Symbol &symbol) {
     const auto &expr = *symbol.expression;
 
     auto vc = Validate_Context {};
-    auto id_table = create_map<Interned_String, int>(context.arena);
-    auto label_fors = create_array<Interned_String>(context.arena);
+    vc.validator = &validator;
+    auto id_table = create_map<Interned_String, int>(*validator.arena);
+    auto label_fors = create_array<Interned_String>(*validator.arena);
 
     if(is_concrete(*symbol.expression)) {
-        if(expr.type == context.strings.page) {
-            vc.id_prefix = context.strings.page;
-        }
-        else {
-            vc.id_prefix = context.strings.empty_string;
-        }
+        auto prefix = expr.type == context.strings.page
+            ? context.strings.page
+            : context.strings.empty_string;
+        vc.id_prefix = intern(*validator.ids, context.string_table[prefix]);
         vc.id_table = &id_table;
         vc.label_fors = &label_fors;
     }
@@ -739,7 +735,134 @@ static bool validate(Symbol &symbol) {
     for(Usize i = 0; i < label_fors.count; i += 1) {
         auto id = label_fors[i];
         if(!has(id_table, id)) {
-            printf("Error: id referenced by label does not exist.\n");
+            return validate_error(validator, "Error: id referenced by label does not exist.");
+        }
+    }
+
+    return true;
+}
+
+
+//
+// RANGE validate symbols.
+//
+
+// NOTE(llw): Validating one symbol on a worker.
+struct Validate_Task {
+    const char *error;
+
+    U32 thread_index;
+    U64 begin_ns;
+    U64 duration_ns;
+    bool ran;
+    bool failed;
+};
+
+struct Validate_Tasks {
+    Validate_Task *values;
+    U32 count;
+    volatile U32 next;
+    volatile U32 failures;
+};
+
+struct Validate_Worker {
+    Thread thread;
+    U32 index;
+    Arena temporary;
+    String_Table ids;
+    Validator validator;
+    Validate_Tasks *tasks;
+    bool started;
+};
+
+static void validate_worker_proc(void *data) {
+    auto &worker = *(Validate_Worker *)data;
+    auto &tasks = *worker.tasks;
+
+    // NOTE(llw): Tasks are taken in order, so after a failure, the ones
+    //  before it are all taken and finish. Only later ones are skipped.
+    while(tasks.failures == 0) {
+        auto index = atomic_add(&tasks.next, 1);
+        if(index >= tasks.count) {
+            break;
+        }
+
+        auto &task = tasks.values[index];
+        task.thread_index = worker.index;
+        task.begin_ns = get_time_ns();
+
+        worker.validator.error = NULL;
+        if(!validate(worker.validator, context.symbols.entries[index].value)) {
+            task.failed = true;
+            task.error = worker.validator.error;
+            atomic_add(&tasks.failures, 1);
+        }
+
+        task.duration_ns = get_time_ns() - task.begin_ns;
+        task.ran = true;
+    }
+}
+
+/* NOTE(llw):
+    - Validates the symbols on context.thread_count workers, like
+      instantiate_exports. Validation only reads the symbols and the string
+      table.
+    - Reports the failure of the first symbol in symbol order, so the output
+      doesn't depend on the thread count.
+*/
+static bool validate_symbols() {
+    TEMP_SCOPE(context.temporary);
+
+    auto tasks = Validate_Tasks {};
+    tasks.count = (U32)context.symbols.count;
+    tasks.values = allocate_array<Validate_Task>(tasks.count, context.temporary);
+
+    auto thread_count = get_worker_count(tasks.count);
+    reserve_worker_arenas(thread_count);
+
+    auto workers = allocate_array<Validate_Worker>(thread_count, context.temporary);
+    for(Usize i = 0; i < thread_count; i += 1) {
+        auto &worker = workers[i];
+        auto &arena = *context.worker_arenas[i];
+        worker.index = (U32)i;
+        worker.temporary = create_virtual_arena();
+        worker.ids = create_string_table(arena);
+        worker.validator = make_validator(arena, worker.temporary, worker.ids);
+        worker.tasks = &tasks;
+    }
+
+    // NOTE(llw): The main thread is worker 0, like parse_sources.
+    for(Usize i = 1; i < thread_count; i += 1) {
+        workers[i].started = create_thread(workers[i].thread, validate_worker_proc, &workers[i]);
+    }
+
+    validate_worker_proc(&workers[0]);
+
+    for(Usize i = 1; i < thread_count; i += 1) {
+        if(workers[i].started) {
+            join_thread(workers[i].thread);
+        }
+    }
+
+    for(Usize i = 0; i < thread_count; i += 1) {
+        destroy(workers[i].temporary);
+    }
+
+    for(U32 i = 0; i < tasks.count; i += 1) {
+        auto &task = tasks.values[i];
+        if(task.ran) {
+            push_trace_event(context.trace,
+                "validate", context.symbols.entries[i].key,
+                task.begin_ns, task.duration_ns,
+                task.thread_index
+            );
+        }
+    }
+
+    for(U32 i = 0; i < tasks.count; i += 1) {
+        auto &task = tasks.values[i];
+        if(task.failed) {
+            printf("%s\n", task.error);
             return false;
         }
     }
@@ -748,23 +871,167 @@ static bool validate(Symbol &symbol) {
 }
 
 
+//
+// RANGE instantiate context.
+//
+
+struct Instantiating {
+    Interned_String symbol;
+    Instantiating *next;
+};
+
+// NOTE(llw): The state of one thread that instantiates. Threads share
+//  context.ast and the memoized instances, see instantiate_exports.
+struct Instantiate_Context {
+    Arena *arena;
+    Arena *temporary;
+
+    // NOTE(llw): The symbols being instantiated, innermost first. Catches
+    //  cycles through inherits that were parameters, the others are found up
+    //  front, see find_inheritance_cycle.
+    Instantiating *instantiating;
+
+    // NOTE(llw): Of the first failure, printed by the caller.
+    const char *error;
+
+    U64 duplicates;
+    U64 instance_hits;
+};
+
+static Instantiate_Context make_instantiate_context(Arena &arena, Arena &temporary) {
+    auto ic = Instantiate_Context {};
+    ic.arena = &arena;
+    ic.temporary = &temporary;
+    return ic;
+}
+
+static bool instantiate_error(Instantiate_Context &ic, const char *message) {
+    ic.error = message;
+    return false;
+}
+
+
+//
+// RANGE copy on write.
+//
+
+/* NOTE(llw):
+    - Instances share the blocks and lists of their definitions. Pool
+      entries don't change after they are filled, a block or list with a
+      changed entry moves to a new range.
+    - Range_Writer makes that copy lazily, nothing is copied until the first
+      entry changes. So only the paths to changed expressions are copied,
+      unchanged subtrees stay shared.
+    - An expression copied out of a range shares its spilled argument map
+      with the entry, own_arguments duplicates it before the first change.
+*/
+template <typename T>
+struct Range_Writer {
+    Array<T> *pool_values;
+    Ast_Range (*allocate)(Ast_Pool &pool, Usize count);
+    Arena *temporary;
+
+    Ast_Range source;
+    // NOTE(llw): Source entries before next are in values.
+    U32 next;
+    bool changed;
+    Array<T> values;
+};
+
+template <typename T>
+static Range_Writer<T> make_range_writer(
+    Instantiate_Context &ic,
+    Array<T> &pool_values, Ast_Range (*allocate)(Ast_Pool &pool, Usize count),
+    Ast_Range source
+) {
+    auto writer = Range_Writer<T> {};
+    writer.pool_values = &pool_values;
+    writer.allocate = allocate;
+    writer.temporary = ic.temporary;
+    writer.source = source;
+    return writer;
+}
+
+template <typename T>
+static void push_source(Range_Writer<T> &writer, U32 end) {
+    auto source = writer.pool_values->values + writer.source.first;
+    for(U32 i = writer.next; i < end; i += 1) {
+        push(writer.values, source[i]);
+    }
+    writer.next = end;
+}
+
+// NOTE(llw): Replaces the source entry at index with count values. index
+//  must increase from call to call.
+template <typename T>
+static void replace(Range_Writer<T> &writer, U32 index, const T *values, Usize count) {
+    assert(index >= writer.next && index < writer.source.count);
+
+    if(!writer.changed) {
+        writer.values = create_array<T>(*writer.temporary, writer.source.count);
+        writer.changed = true;
+    }
+
+    push_source(writer, index);
+    for(Usize i = 0; i < count; i += 1) {
+        push(writer.values, values[i]);
+    }
+    writer.next = index + 1;
+}
+
+// NOTE(llw): Returns the source if nothing was replaced.
+template <typename T>
+static Ast_Range finish(Range_Writer<T> &writer) {
+    if(!writer.changed) {
+        return writer.source;
+    }
+
+    push_source(writer, writer.source.count);
+
+    auto range = writer.allocate(context.ast, writer.values.count);
+    copy_values(writer.pool_values->values + range.first, writer.values.values, writer.values.count);
+    return range;
+}
+
+static void own_arguments(Instantiate_Context &ic, Expression &expr, bool &owned) {
+    if(!owned) {
+        expr.arguments = duplicate(expr.arguments, *ic.arena);
+        owned = true;
+    }
+}
+
+// NOTE(llw): Bitwise, false if the value or range changed.
+static _inline bool same(const Argument &a, const Argument &b) {
+    return a.type == b.type
+        && a.block.first == b.block.first
+        && a.block.count == b.block.count;
+}
+
+
 static void merge_arguments(
-    Map<Interned_String, Argument> &dest,
-    const Map<Interned_String, Argument> &src
+    Argument_Map &dest,
+    const Argument_Map &src
 ) {
     for(Usize i = 0; i < src.count; i += 1) {
-        auto name = src.entries[i].key;
-        auto value = src.entries[i].value;
+        auto name = get_key(src, i);
+        auto value = get_value(src, i);
 
         if(    name == context.strings.style_sheets
             || name == context.strings.scripts
             || name == context.strings.classes
             || name == context.strings.styles
         ) {
-            auto &list = value.list;
             auto dest_values = get_pointer(dest, name);
             if(dest_values) {
-                push_front(dest_values->list, list);
+                // NOTE(llw): Ranges can't grow, the concatenation is a new one.
+                auto &pool = context.ast;
+                auto front = value.list;
+                auto back = dest_values->list;
+                auto range = allocate_arguments(pool, front.count + back.count);
+                auto values = get_arguments(pool, range).values;
+                copy_values(values, get_arguments(pool, front).values, front.count);
+                copy_values(values + front.count, get_arguments(pool, back).values, back.count);
+                dest_values->list = range;
             }
             else {
                 insert(dest, name, value);
@@ -778,8 +1045,9 @@ static void merge_arguments(
 
 
 static bool insert_arguments(
+    Instantiate_Context &ic,
     Argument &arg,
-    const Map<Interned_String, Argument> parameters
+    const Argument_Map &parameters
 ) {
     switch(arg.type) {
         case ARG_ATOM: {
@@ -796,75 +1064,96 @@ static bool insert_arguments(
         } break;
 
         case ARG_LIST: {
-            auto &list = arg.list;
-            for(Usize i = 0; i < list.count; i += 1) {
-                if(!insert_arguments(list[i], parameters)) {
+            TEMP_SCOPE(*ic.temporary);
+            auto &pool = context.ast;
+
+            auto source = arg.list;
+            auto items = get_arguments(pool, source);
+            auto writer = make_range_writer(ic, pool.arguments, allocate_arguments, source);
+            for(U32 i = 0; i < source.count; i += 1) {
+                auto item = items[i];
+                if(!insert_arguments(ic, item, parameters)) {
                     return false;
                 }
+
+                if(!same(item, items[i])) {
+                    replace(writer, i, &item, 1);
+                }
             }
+            arg.list = finish(writer);
 
             return true;
         } break;
 
         case ARG_BLOCK: {
-            auto &block = arg.block;
-            for(Usize i = 0; i < block.count; ) {
-                auto &expr = block[i];
+            TEMP_SCOPE(*ic.temporary);
+            auto &pool = context.ast;
+
+            auto source = arg.block;
+            auto exprs = get_expressions(pool, source);
+            auto writer = make_range_writer(ic, pool.expressions, allocate_expressions, source);
+            for(U32 i = 0; i < source.count; i += 1) {
+                auto expr = exprs[i];
+                auto owned = false;
+                auto changed = false;
 
                 // NOTE(llw): Replace expression arguments.
-                auto &args = expr.arguments;
-                for(Usize j = 0; j < args.count; j += 1) {
-                    if(!insert_arguments(args.entries[j].value, parameters)) {
+                for(Usize j = 0; j < expr.arguments.count; j += 1) {
+                    auto value = get_value(expr.arguments, j);
+                    if(!insert_arguments(ic, value, parameters)) {
                         return false;
                     }
+
+                    if(!same(value, get_value(expr.arguments, j))) {
+                        own_arguments(ic, expr, owned);
+                        get_value(expr.arguments, j) = value;
+                        changed = true;
+                    }
                 }
 
                 // NOTE(llw): Expression is to be replaced completely.
-                auto replace = get_pointer(parameters, expr.type);
-                if(replace) {
+                auto replacement = get_pointer(parameters, expr.type);
+                if(replacement) {
 
-                    if(replace->type == ARG_ATOM) {
-                        expr.type = replace->value;
+                    if(replacement->type == ARG_ATOM) {
+                        expr.type = replacement->value;
+                        changed = true;
                     }
-                    else if(replace->type == ARG_BLOCK) {
-                        // NOTE(llw): Back up arguments before replacing.
-                        auto args = expr.arguments;
-
-                        // NOTE(llw): Replace expr with the block's expressions.
-                        auto amount = replace->block.count;
-                        if(amount > 0) {
-                            // NOTE(llw): Like push_at but removes block[i].
-                            make_space_at(block, i, amount - 1);
-                            copy_values(block.values + i, replace->block.values, amount);
-                        }
-                        else {
-                            remove_at(block, i);
-                        }
+                    else if(replacement->type == ARG_BLOCK) {
+                        auto &args = expr.arguments;
+                        auto amount = replacement->block.count;
 
                         // NOTE(llw): Args only allowed if inserting at most one expression.
                         if(args.count > 0 && amount > 1) {
-                            printf("Cannot insert expressions. Original expression has arguments.\n");
-                            return false;
+                            return instantiate_error(ic, "Cannot insert expressions. Original expression has arguments.");
                         }
 
+                        // NOTE(llw): Replace expr with the block's expressions.
                         if(amount == 1) {
-                            merge_arguments(block[i].arguments, args);
+                            auto inserted = get_block(*replacement)[0];
+                            auto inserted_owned = false;
+                            own_arguments(ic, inserted, inserted_owned);
+                            merge_arguments(inserted.arguments, args);
+                            replace(writer, i, &inserted, 1);
+                        }
+                        else {
+                            auto values = get_block(*replacement).values;
+                            replace(writer, i, values, amount);
                         }
 
-
-                        // NOTE(llw): Skip inserted expressions.
-                        i += amount;
                         continue;
                     }
                     else {
-                        printf("Cannot replace expression. Not an atom or block.\n");
-                        return false;
+                        return instantiate_error(ic, "Cannot replace expression. Not an atom or block.");
                     }
 
                 }
 
-                i += 1;
+                if(changed) {
+                    replace(writer, i, &expr, 1);
+                }
             }
+            arg.block = finish(writer);
 
             return true;
         } break;
@@ -877,8 +1166,8 @@ static bool insert_arguments(
 }
 
 
-static bool instantiate_and_merge(Expression &reference, Argument inherits);
-static bool instantiate_body_references(Expression &expression);
+static bool instantiate_and_merge(Instantiate_Context &ic, Expression &reference, Argument inherits);
+static bool instantiate_body_references(Instantiate_Context &ic, Argument &body);
 
 /* NOTE(llw):
     - Both reference and definition are modified!
@@ -887,12 +1176,14 @@ static bool instantiate_body_references(Expression &expression);
     - "On way up", merging takes place:
         - For style_sheets, scripts, classes, styles lists: Concatenate.
         - Others: Outermost writer wins.
+    - The argument maps of both must be their own (see own_arguments).
 */
 static bool instantiate(
+    Instantiate_Context &ic,
     Expression *reference,
     Expression &definition
 ) {
-    TEMP_SCOPE(context.temporary);
+    TEMP_SCOPE(*ic.temporary);
 
 
     auto &args = definition.arguments;
@@ -903,9 +1194,10 @@ static bool instantiate(
         assert(reference != NULL);
 
         // NOTE(llw): Collect arguments from reference.
-        auto arguments = create_map<Interned_String, Argument>(context.temporary);
-        for(Usize i = 0; i < parameters->list.count; i += 1) {
-            auto name = parameters->list[i].value;
+        auto arguments = create_argument_map(*ic.temporary);
+        auto list = get_list(*parameters);
+        for(Usize i = 0; i < list.count; i += 1) {
+            auto name = list[i].value;
             insert(arguments, name, reference->arguments[name]);
 
             // NOTE(llw): Remove argument from reference.
@@ -917,78 +1209,309 @@ static bool instantiate(
 
         // NOTE(llw): Insert arguments into definition.
         for(Usize i = 0; i < args.count; i += 1) {
-            auto &arg = args.entries[i].value;
-            if(!insert_arguments(arg, arguments)) {
+            auto &arg = get_value(args, i);
+            if(!insert_arguments(ic, arg, arguments)) {
                 return false;
             }
         }
     }
 
-    if(!instantiate_body_references(definition)) {
-        return false;
+    auto body = get_pointer(args, context.strings.body);
+    if(body != NULL) {
+        if(!instantiate_body_references(ic, *body)) {
+            return false;
+        }
     }
 
     // NOTE(llw): Recurse.
     auto inherits = get_pointer(args, context.strings.inherits);
     if(inherits != NULL) {
-        if(!instantiate_and_merge(definition, *inherits)) {
+        if(!instantiate_and_merge(ic, definition, *inherits)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//
+// RANGE instance memo.
+//
+
+static _inline U64 hash_value(U64 value, U64 seed) {
+    return murmur_hash_64(&value, sizeof(value), seed);
+}
+
+static U64 hash_argument(const Argument &arg, U64 seed);
+
+// NOTE(llw): Structural, and independent of the argument order.
+static U64 hash_expression(const Expression &expr, U64 seed) {
+    auto result = hash_value(expr.type, seed);
+
+    auto sum = (U64)0;
+    for(Usize i = 0; i < expr.arguments.count; i += 1) {
+        auto key = get_key(expr.arguments, i);
+        sum += hash_argument(get_value(expr.arguments, i), hash_value(key, seed));
+    }
+
+    return hash_value(sum, result);
+}
+
+static U64 hash_argument(const Argument &arg, U64 seed) {
+    auto result = hash_value(arg.type, seed);
+
+    switch(arg.type) {
+        // NOTE(llw): Numbers by spelling, like equal_arguments.
+        case ARG_ATOM:
+        case ARG_STRING:
+        case ARG_NUMBER: {
+            result = hash_value(arg.value, result);
+        } break;
+
+        case ARG_BLOCK: {
+            auto block = get_block(arg);
+            for(Usize i = 0; i < block.count; i += 1) {
+                result = hash_expression(block[i], result);
+            }
+        } break;
+
+        case ARG_LIST: {
+            auto list = get_list(arg);
+            for(Usize i = 0; i < list.count; i += 1) {
+                result = hash_argument(list[i], result);
+            }
+        } break;
+    }
+
+    return result;
+}
+
+static bool equal_arguments(const Argument &a, const Argument &b);
+
+static bool equal_expressions(const Expression &a, const Expression &b) {
+    if(a.type != b.type || a.arguments.count != b.arguments.count) {
+        return false;
+    }
+
+    for(Usize i = 0; i < a.arguments.count; i += 1) {
+        auto other = get_pointer(b.arguments, get_key(a.arguments, i));
+        if(other == NULL || !equal_arguments(get_value(a.arguments, i), *other)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool equal_arguments(const Argument &a, const Argument &b) {
+    if(a.type != b.type) {
+        return false;
+    }
+
+    switch(a.type) {
+        case ARG_ATOM:
+        case ARG_STRING:
+        case ARG_NUMBER: {
+            return a.value == b.value;
+        } break;
+
+        case ARG_BLOCK: {
+            if(same(a, b)) {
+                return true;
+            }
+
+            auto left = get_block(a);
+            auto right = get_block(b);
+            if(left.count != right.count) {
+                return false;
+            }
+
+            for(Usize i = 0; i < left.count; i += 1) {
+                if(!equal_expressions(left[i], right[i])) {
+                    return false;
+                }
+            }
+            return true;
+        } break;
+
+        case ARG_LIST: {
+            if(same(a, b)) {
+                return true;
+            }
+
+            auto left = get_list(a);
+            auto right = get_list(b);
+            if(left.count != right.count) {
+                return false;
+            }
+
+            for(Usize i = 0; i < left.count; i += 1) {
+                if(!equal_arguments(left[i], right[i])) {
+                    return false;
+                }
+            }
+            return true;
+        } break;
+
+        default: {
+            assert(false);
             return false;
+        } break;
+    }
+}
+
+
+/* NOTE(llw):
+    - Instantiates the symbol named name for reference (NULL for exports and
+      list items). Removes the parameter values from reference.
+    - The instance only depends on the symbol and the values of its
+      parameters. So instances are memoized by them, and every later
+      reference with equal values shares the first one's blocks and lists.
+    - result gets its own argument map.
+*/
+static bool instantiate_symbol(
+    Instantiate_Context &ic,
+    Interned_String name,
+    Expression *reference,
+    Expression &result
+) {
+    TEMP_SCOPE(*ic.temporary);
+
+    auto &symbol = context.symbols[name];
+    auto &pool = context.ast;
+
+    // NOTE(llw): Collect parameter values, in parameter list order.
+    auto values = create_array<Argument>(*ic.temporary);
+    auto hash = hash_value(name, 0);
+
+    auto parameters = get_pointer(symbol.expression->arguments, context.strings.parameters);
+    if(parameters != NULL) {
+        assert(reference != NULL);
+
+        auto list = get_list(*parameters);
+        for(Usize i = 0; i < list.count; i += 1) {
+            auto &value = reference->arguments[list[i].value];
+            push(values, value);
+            hash = hash_argument(value, hash);
+        }
+    }
+
+    // NOTE(llw): Reuse. Memoized instances don't change, they are only
+    //  compared outside of the lock.
+    auto memoized = false;
+    auto instance = Symbol_Instance {};
+    {
+        LOCK_SCOPE(context.instance_lock);
+        auto index = get_pointer(context.instance_table, hash);
+        if(index != NULL) {
+            memoized = true;
+            instance = context.instances[*index];
+        }
+    }
+
+    if(memoized) {
+        auto arguments = get_arguments(pool, instance.arguments);
+        auto equal = instance.symbol == name;
+        for(Usize i = 0; equal && i < values.count; i += 1) {
+            equal = equal_arguments(arguments[i], values[i]);
+        }
+
+        if(equal) {
+            ic.instance_hits += 1;
+
+            if(parameters != NULL) {
+                auto list = get_list(*parameters);
+                for(Usize i = 0; i < list.count; i += 1) {
+                    remove(reference->arguments, list[i].value);
+                }
+            }
+
+            ic.duplicates += 1;
+            result = duplicate(instance.expression, *ic.arena);
+            return true;
+        }
+    }
+
+    auto instantiating = Instantiating { name, ic.instantiating };
+    ic.instantiating = &instantiating;
+
+    ic.duplicates += 1;
+    result = duplicate(*symbol.expression, *ic.arena);
+    if(!instantiate(ic, reference, result)) {
+        return false;
+    }
+
+    ic.instantiating = instantiating.next;
+
+    // NOTE(llw): Memoize. If another thread was first, or on a hash
+    //  collision, the first one stays.
+    if(!memoized) {
+        instance = Symbol_Instance {};
+        instance.symbol = name;
+        instance.arguments = allocate_arguments(pool, values.count);
+        copy_values(get_arguments(pool, instance.arguments).values, values.values, values.count);
+        instance.expression = result;
+
+        {
+            LOCK_SCOPE(context.instance_lock);
+            if(insert_maybe(context.instance_table, hash, context.instances.count)) {
+                push(context.instances, instance);
+            }
         }
+
+        // NOTE(llw): The memoized map must not change.
+        result.arguments = duplicate(result.arguments, *ic.arena);
     }
 
     return true;
 }
 
-static bool instantiate_and_merge(Expression &reference, Argument inherits) {
+static bool instantiate_and_merge(Instantiate_Context &ic, Expression &reference, Argument inherits) {
 
     // NOTE(llw): Validate inheritance.
     Symbol *symbol;
     {
         if(inherits.type != ARG_STRING) {
-            printf("Error: 'inherits' must be a string.\n");
-            return false;
+            return instantiate_error(ic, "Error: 'inherits' must be a string.");
         }
 
         // NOTE(llw): Existence.
         symbol = get_pointer(context.symbols, inherits.value);
         if(symbol == NULL) {
-            printf("Error: Referenced symbol does not exist.\n");
-            return false;
+            return instantiate_error(ic, "Error: Referenced symbol does not exist.");
         }
 
         // NOTE(llw): Circular dependency.
-        if(symbol->instantiating) {
-            printf("Error: Circular inheritance.\n");
-            return false;
+        for(auto at = ic.instantiating; at != NULL; at = at->next) {
+            if(at->symbol == inherits.value) {
+                return instantiate_error(ic, "Error: Circular inheritance.");
+            }
         }
 
         // NOTE(llw): Type.
         if(symbol->expression->type != reference.type) {
-            printf("Error: Referenced symbol is of a different type.\n");
-            return false;
+            return instantiate_error(ic, "Error: Referenced symbol is of a different type.");
         }
 
         // NOTE(llw): Check parameters provided.
         auto parameters = get_pointer(symbol->expression->arguments, context.strings.parameters);
         if(parameters != NULL) {
-            const auto &list = parameters->list;
+            auto list = get_list(*parameters);
             for(Usize i = 0; i < list.count; i += 1) {
                 auto name = list[i].value;
                 if(!has(reference.arguments, name)) {
-                    printf("Parameter not provided.\n");
-                    return false;
+                    return instantiate_error(ic, "Parameter not provided.");
                 }
             }
         }
     }
 
 
-    symbol->instantiating = true;
-    auto instance = duplicate(*symbol->expression, context.arena);
-    if(!instantiate(&reference, instance)) {
+    auto instance = Expression {};
+    if(!instantiate_symbol(ic, inherits.value, &reference, instance)) {
         return false;
     }
-    symbol->instantiating = false;
 
     auto &inst_args = instance.arguments;
     auto &def_args  = reference.arguments;
@@ -1002,46 +1525,74 @@ static bool instantiate_and_merge(Expression &reference, Argument inherits) {
     return true;
 };
 
-static bool instantiate_body_references(Expression &expression) {
-    auto body = get_pointer(expression.arguments, context.strings.body);
-    if(body) {
-        auto &block = body->block;
-        for(Usize expr_index = 0; expr_index < block.count; expr_index += 1) {
-            auto &expr = block[expr_index];
-
-            auto inherits = get_pointer(expr.arguments, context.strings.inherits);
-            if(inherits != NULL) {
-                if(!instantiate_and_merge(expr, *inherits)) {
-                    return false;
-                }
+// NOTE(llw): Copies body along the paths to expressions that inherit.
+static bool instantiate_body_references(Instantiate_Context &ic, Argument &body) {
+    assert(body.type == ARG_BLOCK);
+
+    TEMP_SCOPE(*ic.temporary);
+    auto &pool = context.ast;
+
+    auto source = body.block;
+    auto exprs = get_expressions(pool, source);
+    auto writer = make_range_writer(ic, pool.expressions, allocate_expressions, source);
+    for(U32 i = 0; i < source.count; i += 1) {
+        auto expr = exprs[i];
+        auto owned = false;
+
+        auto inherits = get_pointer(expr.arguments, context.strings.inherits);
+        if(inherits != NULL) {
+            auto value = *inherits;
+            own_arguments(ic, expr, owned);
+            if(!instantiate_and_merge(ic, expr, value)) {
+                return false;
             }
+        }
 
-            // NOTE(llw): Recurse.
-            if(!instantiate_body_references(expr)) {
+        // NOTE(llw): Recurse.
+        auto expr_body = get_pointer(expr.arguments, context.strings.body);
+        if(expr_body != NULL) {
+            auto value = *expr_body;
+            if(!instantiate_body_references(ic, value)) {
                 return false;
             }
+
+            if(!same(value, *expr_body)) {
+                own_arguments(ic, expr, owned);
+                expr.arguments[context.strings.body] = value;
+            }
+        }
+
+        if(owned) {
+            replace(writer, i, &expr, 1);
         }
     }
+    body.block = finish(writer);
 
     return true;
 };
 
-static bool instantiate_list_initials(Expression &expr) {
-    auto &args = expr.arguments;
+static bool instantiate_list_initials(Instantiate_Context &ic, Argument &body);
+
+// NOTE(llw): owned tells whether expr's argument map is its own, see
+//  own_arguments. Set if expr changed.
+static bool instantiate_list_initials(Instantiate_Context &ic, Expression &expr, bool &owned) {
 
     // NOTE(llw): Recurse.
-    auto body = get_pointer(args, context.strings.body);
+    auto body = get_pointer(expr.arguments, context.strings.body);
     if(body != NULL) {
-        assert(body->type == ARG_BLOCK);
+        auto value = *body;
+        if(!instantiate_list_initials(ic, value)) {
+            return false;
+        }
 
-        auto &block = body->block;
-        for(Usize i = 0; i < block.count; i += 1) {
-            if(!instantiate_list_initials(block[i])) {
-                return false;
-            }
+        if(!same(value, *body)) {
+            own_arguments(ic, expr, owned);
+            expr.arguments[context.strings.body] = value;
         }
     }
 
+    auto &args = expr.arguments;
+
     // NOTE(llw): Skip non-lists.
     if(expr.type != context.strings.list) {
         return true;
@@ -1057,31 +1608,35 @@ static bool instantiate_list_initials(Expression &expr) {
         return true;
     }
 
-    auto count = parse_int(context.string_table[initial->value]);
+    auto count = initial->number;
     if(count == 0) {
         return true;
     }
 
     auto symbol_name = args[context.strings.type].value;
-    const auto &type = *context.symbols[symbol_name].expression;
 
-    auto list_body = create_argument(ARG_BLOCK, context.arena);
-    reserve(list_body.block, count);
+    auto &pool = context.ast;
 
-    for(Usize i = 0; i < count; i += 1) {
+    auto list_body = Argument {};
+    list_body.type = ARG_BLOCK;
+    list_body.block = allocate_expressions(pool, count);
+    auto items = get_block(list_body);
+
+    for(U32 i = 0; i < count; i += 1) {
         // NOTE(llw): Build body.
-        auto instance = duplicate(type, context.arena);
-        if(!instantiate(NULL, instance)) {
+        auto instance = Expression {};
+        if(!instantiate_symbol(ic, symbol_name, NULL, instance)) {
             return false;
         }
 
-        auto body = create_argument(ARG_BLOCK, context.arena);
-        reserve(body.block, 1);
-        push(body.block, instance);
+        auto body = Argument {};
+        body.type = ARG_BLOCK;
+        body.block = allocate_expressions(pool, 1);
+        get_block(body)[0] = instance;
 
         // NOTE(llw): Build id.
-        TEMP_SCOPE(context.temporary);
-        auto id_string = create_array<U8>(context.temporary);
+        TEMP_SCOPE(*ic.temporary);
+        auto id_string = create_array<U8>(*ic.temporary);
         push(id_string, STRING("tn_list_item_"));
         push_int(id_string, i);
 
@@ -1092,44 +1647,70 @@ static bool instantiate_list_initials(Expression &expr) {
         // NOTE(llw): Build wrapper div.
         auto div = Expression {};
         div.type = context.strings.div;
-        div.arguments.allocator = &context.arena;
+        div.arguments = create_argument_map(*ic.arena);
 
-        reserve(div.arguments, 2);
         insert(div.arguments, context.strings.body, body);
         insert(div.arguments, context.strings.id,   id);
 
-        push(list_body.block, div);
+        items[i] = div;
     }
-    insert(args, context.strings.body, list_body);
+
+    own_arguments(ic, expr, owned);
+    insert(expr.arguments, context.strings.body, list_body);
 
     return true;
 }
 
-static Expression *instantiate(const Expression &expr) {
-    auto result = allocate<Expression>(context.arena);
-    *result = duplicate(expr, context.arena);
+// NOTE(llw): Copies body along the paths to lists with initial items.
+static bool instantiate_list_initials(Instantiate_Context &ic, Argument &body) {
+    assert(body.type == ARG_BLOCK);
 
-    if(!instantiate(NULL, *result)) {
-        return NULL;
+    TEMP_SCOPE(*ic.temporary);
+    auto &pool = context.ast;
+
+    auto source = body.block;
+    auto exprs = get_expressions(pool, source);
+    auto writer = make_range_writer(ic, pool.expressions, allocate_expressions, source);
+    for(U32 i = 0; i < source.count; i += 1) {
+        auto expr = exprs[i];
+        auto owned = false;
+        if(!instantiate_list_initials(ic, expr, owned)) {
+            return false;
+        }
+
+        if(owned) {
+            replace(writer, i, &expr, 1);
+        }
     }
+    body.block = finish(writer);
+
+    return true;
+}
 
+// NOTE(llw): The steps after instantiating an export. Intern and add
+//  referenced files, so only on the main thread.
+static bool finish_export(Instantiate_Context &ic, Expression *result) {
     assert(is_concrete(*result));
 
     auto symbol = Symbol {};
     symbol.expression = result;
-    if(!validate(symbol)) {
-        return NULL;
+    auto validator = make_validator(*ic.arena, *ic.temporary, context.string_table);
+    if(!validate(validator, symbol)) {
+        printf("%s\n", validator.error);
+        return false;
     }
 
-    if(!instantiate_list_initials(*result)) {
-        return NULL;
+    auto owned = true;
+    if(!instantiate_list_initials(ic, *result, owned)) {
+        printf("%s\n", ic.error);
+        return false;
     }
 
     // NOTE(llw): Collect referenced files.
     if(result->type == context.strings.page) {
         auto style_sheets = get_pointer(result->arguments, context.strings.style_sheets);
         if(style_sheets) {
-            const auto &list = style_sheets->list;
+            auto list = get_list(*style_sheets);
             for(Usize i = 0; i < list.count; i += 1) {
                 insert_maybe(context.referenced_files, list[i].value, 0);
             }
@@ -1137,7 +1718,7 @@ static Expression *instantiate(const Expression &expr) {
 
         auto scripts = get_pointer(result->arguments, context.strings.scripts);
         if(scripts) {
-            const auto &list = scripts->list;
+            auto list = get_list(*scripts);
             for(Usize i = 0; i < list.count; i += 1) {
                 insert_maybe(context.referenced_files, list[i].value, 0);
             }
@@ -1151,26 +1732,319 @@ static Expression *instantiate(const Expression &expr) {
 
     // NOTE(llw): Add default scripts.
     if(result->type == context.strings.page) {
-        auto default_scripts = create_argument(ARG_LIST, context.arena);
+        auto &pool = context.ast;
 
-        auto runtime = create_argument(ARG_STRING, context.arena);
-        runtime.value = intern(context.string_table, STRING("runtime.js"));
-        push(default_scripts.list, runtime);
+        auto scripts = get_pointer(result->arguments, context.strings.scripts);
+        auto user_count = scripts != NULL ? scripts->list.count : 0;
 
-        auto instantiate = create_argument(ARG_STRING, context.arena);
-        instantiate.value = intern(context.string_table, STRING("instantiate.js"));
-        push(default_scripts.list, instantiate);
+        auto default_scripts = Argument {};
+        default_scripts.type = ARG_LIST;
+        default_scripts.list = allocate_arguments(pool, 2 + user_count);
+        auto list = get_list(default_scripts);
+
+        list[0] = Argument {};
+        list[0].type = ARG_STRING;
+        list[0].value = intern(context.string_table, STRING("runtime.js"));
+
+        list[1] = Argument {};
+        list[1].type = ARG_STRING;
+        list[1].value = intern(context.string_table, STRING("instantiate.js"));
 
-        auto scripts = get_pointer(result->arguments, context.strings.scripts);
         if(scripts == NULL) {
             insert(result->arguments, context.strings.scripts, default_scripts);
         }
         else {
-            push(default_scripts.list, scripts->list);
+            copy_values(&list[2], get_list(*scripts).values, user_count);
             scripts->list = default_scripts.list;
         }
     }
 
-    return result;
+    return true;
+}
+
+
+//
+// RANGE dependencies.
+//
+
+struct Symbol_Edge {
+    // NOTE(llw): Into context.symbols.entries.
+    U32 symbol;
+};
+
+// NOTE(llw): The symbols that instantiating a symbol may instantiate. The
+//  edges of symbol i are edges[first[i] .. first[i + 1]).
+struct Symbol_Graph {
+    Array<U32> first;
+    Array<Symbol_Edge> edges;
+};
+
+// NOTE(llw): Skips names that aren't strings of symbols, instantiating
+//  reports those.
+static void add_edge(Symbol_Graph &graph, const Argument *name) {
+    if(name == NULL || name->type != ARG_STRING) {
+        return;
+    }
+
+    auto symbol = get_pointer(context.symbols, name->value);
+    if(symbol == NULL) {
+        return;
+    }
+
+    push(graph.edges, Symbol_Edge { symbol->index });
+}
+
+static void add_edges(Symbol_Graph &graph, const Expression &expr);
+
+static void add_edges(Symbol_Graph &graph, const Argument &arg) {
+    if(arg.type == ARG_BLOCK) {
+        auto block = get_block(arg);
+        for(Usize i = 0; i < block.count; i += 1) {
+            add_edges(graph, block[i]);
+        }
+    }
+    else if(arg.type == ARG_LIST) {
+        auto list = get_list(arg);
+        for(Usize i = 0; i < list.count; i += 1) {
+            add_edges(graph, list[i]);
+        }
+    }
+}
+
+// NOTE(llw): Blocks that are arguments other than body count as well, they
+//  may be inserted into one.
+static void add_edges(Symbol_Graph &graph, const Expression &expr) {
+    auto &args = expr.arguments;
+
+    add_edge(graph, get_pointer(args, context.strings.inherits));
+    if(expr.type == context.strings.list) {
+        add_edge(graph, get_pointer(args, context.strings.type));
+    }
+
+    for(Usize i = 0; i < args.count; i += 1) {
+        add_edges(graph, get_value(args, i));
+    }
+}
+
+static Symbol_Graph build_symbol_graph(Allocator &allocator) {
+    auto graph = Symbol_Graph {};
+    graph.first = create_array<U32>(allocator, context.symbols.count + 1);
+    graph.edges = create_array<Symbol_Edge>(allocator);
+
+    for(Usize i = 0; i < context.symbols.count; i += 1) {
+        push(graph.first, (U32)graph.edges.count);
+        add_edges(graph, *context.symbols.entries[i].value.expression);
+    }
+    push(graph.first, (U32)graph.edges.count);
+
+    return graph;
+}
+
+enum Visit_State : U8 {
+    VISIT_NEW,
+    VISIT_ACTIVE,
+    VISIT_DONE,
+};
+
+// NOTE(llw): Dependencies before dependents. Edges that close a cycle are
+//  ignored, instantiating reports inheritance cycles.
+static void push_post_order(
+    const Symbol_Graph &graph, Visit_State *states, U32 symbol,
+    Array<U32> &order
+) {
+    states[symbol] = VISIT_ACTIVE;
+
+    for(auto i = graph.first[symbol]; i < graph.first[symbol + 1]; i += 1) {
+        auto edge = graph.edges[i];
+        if(states[edge.symbol] == VISIT_NEW) {
+            push_post_order(graph, states, edge.symbol, order);
+        }
+    }
+
+    states[symbol] = VISIT_DONE;
+    push(order, symbol);
 }
 
+
+//
+// RANGE exports.
+//
+
+// NOTE(llw): Instantiating one export on a worker.
+struct Instantiate_Task {
+    // NOTE(llw): Into context.symbols.entries.
+    U32 symbol;
+    Expression *result;
+    const char *error;
+
+    U32 thread_index;
+    U64 begin_ns;
+    U64 duration_ns;
+    bool ok;
+};
+
+struct Instantiate_Tasks {
+    Instantiate_Task *values;
+    U32 count;
+    volatile U32 next;
+};
+
+struct Instantiate_Worker {
+    Thread thread;
+    U32 index;
+    Arena temporary;
+    Instantiate_Context ic;
+    Instantiate_Tasks *tasks;
+    bool started;
+};
+
+static void run_instantiate_task(Instantiate_Task &task, Instantiate_Context &ic, U32 thread_index) {
+    task.thread_index = thread_index;
+    task.begin_ns = get_time_ns();
+
+    ic.instantiating = NULL;
+    ic.error = NULL;
+
+    auto name = context.symbols.entries[task.symbol].key;
+    task.result = allocate<Expression>(*ic.arena);
+    task.ok = instantiate_symbol(ic, name, NULL, *task.result);
+    task.error = ic.error;
+
+    task.duration_ns = get_time_ns() - task.begin_ns;
+}
+
+static void instantiate_worker_proc(void *data) {
+    auto &worker = *(Instantiate_Worker *)data;
+    auto &tasks = *worker.tasks;
+
+    while(true) {
+        auto index = atomic_add(&tasks.next, 1);
+        if(index >= tasks.count) {
+            break;
+        }
+
+        run_instantiate_task(tasks.values[index], worker.ic, worker.index);
+    }
+}
+
+/* NOTE(llw):
+    - Instantiates the non-generic symbols into context.exports, in symbol
+      order.
+    - Exports don't depend on each other, they are instantiated on
+      context.thread_count workers, that take the next one as they finish.
+      They share the memoized instances, tasks are in dependency order so
+      those are usually there when needed.
+    - Workers don't print. Failures are reported and the finishing steps
+      run on the main thread in symbol order, so the output doesn't depend
+      on the thread count.
+*/
+static bool instantiate_exports() {
+    TEMP_SCOPE(context.temporary);
+
+    auto symbol_count = context.symbols.count;
+
+    // NOTE(llw): Dependencies. Cycles are left to the tasks that reach them,
+    //  so they are reported in symbol order with the other errors.
+    auto graph = build_symbol_graph(context.temporary);
+    auto states = allocate_array<Visit_State>(symbol_count, context.temporary);
+    auto order = create_array<U32>(context.temporary, symbol_count);
+    for(U32 i = 0; i < symbol_count; i += 1) {
+        if(states[i] == VISIT_NEW) {
+            push_post_order(graph, states, i, order);
+        }
+    }
+
+    // NOTE(llw): Tasks in dependency order, task_of maps back.
+    auto tasks = Instantiate_Tasks {};
+    tasks.values = allocate_array<Instantiate_Task>(symbol_count, context.temporary);
+    auto task_of = allocate_array<U32>(symbol_count, context.temporary);
+    for(Usize i = 0; i < order.count; i += 1) {
+        auto symbol = order[i];
+        if(is_generic(*context.symbols.entries[symbol].value.expression)) {
+            continue;
+        }
+
+        task_of[symbol] = tasks.count;
+        tasks.values[tasks.count].symbol = symbol;
+        tasks.count += 1;
+    }
+
+    auto thread_count = get_worker_count(tasks.count);
+    reserve_worker_arenas(thread_count);
+
+    {
+        auto workers = allocate_array<Instantiate_Worker>(thread_count, context.temporary);
+        for(Usize i = 0; i < thread_count; i += 1) {
+            auto &worker = workers[i];
+            worker.index = (U32)i;
+            worker.temporary = create_virtual_arena();
+            worker.ic = make_instantiate_context(*context.worker_arenas[i], worker.temporary);
+            worker.tasks = &tasks;
+        }
+
+        // NOTE(llw): Shared pools only grow in place, the arrays need values
+        //  for that.
+        if(thread_count > 1) {
+            reserve(context.ast.expressions, 1);
+            reserve(context.ast.arguments, 1);
+            context.ast.lock = &context.ast_lock;
+        }
+
+        // NOTE(llw): The main thread is worker 0, like parse_sources.
+        for(Usize i = 1; i < thread_count; i += 1) {
+            workers[i].started = create_thread(workers[i].thread, instantiate_worker_proc, &workers[i]);
+        }
+
+        instantiate_worker_proc(&workers[0]);
+
+        for(Usize i = 1; i < thread_count; i += 1) {
+            if(workers[i].started) {
+                join_thread(workers[i].thread);
+            }
+        }
+
+        context.ast.lock = NULL;
+
+        for(Usize i = 0; i < thread_count; i += 1) {
+            auto &worker = workers[i];
+            STATS_COUNT(COUNT_DUPLICATES,    worker.ic.duplicates);
+            STATS_COUNT(COUNT_INSTANCE_HITS, worker.ic.instance_hits);
+            destroy(worker.temporary);
+        }
+    }
+
+    for(Usize i = 0; i < tasks.count; i += 1) {
+        auto &task = tasks.values[i];
+        push_trace_event(context.trace,
+            "instantiate", context.symbols.entries[task.symbol].key,
+            task.begin_ns, task.duration_ns,
+            task.thread_index
+        );
+    }
+
+    auto ic = make_instantiate_context(context.arena, context.temporary);
+    defer {
+        STATS_COUNT(COUNT_DUPLICATES,    ic.duplicates);
+        STATS_COUNT(COUNT_INSTANCE_HITS, ic.instance_hits);
+    };
+
+    for(U32 i = 0; i < symbol_count; i += 1) {
+        if(is_generic(*context.symbols.entries[i].value.expression)) {
+            continue;
+        }
+
+        auto &task = tasks.values[task_of[i]];
+        if(!task.ok) {
+            printf("%s\n", task.error);
+            return false;
+        }
+
+        if(!finish_export(ic, task.result)) {
+            return false;
+        }
+
+        push(context.exports, task.result);
+    }
+
+    return true;
+}
@@ -9,6 +9,17 @@ bool analyze();
 
 struct Symbol {
     Expression *expression;
-    bool instantiating;
+    // NOTE(llw): Into context.symbols.entries.
+    U32 index;
+};
+
+// NOTE(llw): An instantiation of a symbol, reused by later references that
+//  provide equal parameter values.
+struct Symbol_Instance {
+    Interned_String symbol;
+    // NOTE(llw): The values of the symbol's parameters, in the order of its
+    //  parameter list.
+    Ast_Range arguments;
+    Expression expression;
 };
 
@@ -0,0 +1,398 @@
+#include "ast_cache.hpp"
+#include "context.hpp"
+
+#pragma warning(disable:4996) // crt secure
+#include "cstdio"
+#include <cstddef>
+
+#include <libcpp/memory/hash.hpp>
+#include <libcpp/util/defer.hpp>
+#include <libcpp/util/thread.hpp>
+
+static constexpr U32 ast_cache_magic = 0x43435357; // "WSCC"
+
+struct Ast_Cache_Header {
+    U32 magic;
+    U32 version;
+    U32 fixed_string_count;
+    // NOTE(llw): Not counting the fixed strings.
+    U32 string_count;
+    U64 content_hash;
+    U64 content_size;
+    U32 expression_count;
+    U32 root_count;
+    // NOTE(llw): Of the whole entry, catches truncated files.
+    U64 size;
+    // NOTE(llw): Of everything after the header. A damaged entry can still
+    //  be well formed, eg. with a byte flipped inside a string.
+    U64 body_hash;
+};
+
+static U64 hash_body(const U8 *values, Usize count) {
+    return murmur_hash_64((void *)values, count, ast_cache_magic);
+}
+
+static U64 hash_content(const Array<U8> &content) {
+    return murmur_hash_64(content.values, content.count, 0x0dc61362440d29b5ULL ^ ast_cache_version);
+}
+
+static void make_entry_path(const char *directory, U64 content_hash, Array<U8> &path) {
+    char name[32];
+    auto size = snprintf(name, sizeof(name), "%016llx.wscc", (unsigned long long)content_hash);
+
+    push(path, String { (U8 *)directory, strlen(directory) });
+    push(path, String { (U8 *)name, (Usize)size });
+    push(path, (U8)0);
+}
+
+
+//
+// RANGE save.
+//
+
+template <typename T>
+static void write_value(Array<U8> &buffer, const T &value) {
+    push_bytes(buffer, (const U8 *)&value, sizeof(value));
+}
+
+static void write_expression(Array<U8> &buffer, const Ast_Pool &pool, const Expression &expression);
+
+static void write_argument(Array<U8> &buffer, const Ast_Pool &pool, const Argument &argument) {
+    write_value(buffer, (U8)argument.type);
+
+    switch(argument.type) {
+        case ARG_ATOM:
+        case ARG_STRING: {
+            write_value(buffer, argument.value);
+        } break;
+
+        case ARG_NUMBER: {
+            write_value(buffer, argument.value);
+            write_value(buffer, argument.number);
+        } break;
+
+        case ARG_BLOCK: {
+            auto block = get_block(pool, argument);
+            write_value(buffer, (U32)block.count);
+            for(Usize i = 0; i < block.count; i += 1) {
+                write_expression(buffer, pool, block[i]);
+            }
+        } break;
+
+        case ARG_LIST: {
+            auto list = get_list(pool, argument);
+            write_value(buffer, (U32)list.count);
+            for(Usize i = 0; i < list.count; i += 1) {
+                write_argument(buffer, pool, list[i]);
+            }
+        } break;
+    }
+}
+
+static void write_expression(Array<U8> &buffer, const Ast_Pool &pool, const Expression &expression) {
+    write_value(buffer, expression.id);
+    write_value(buffer, expression.parent);
+    write_value(buffer, expression.type);
+
+    auto &arguments = expression.arguments;
+    write_value(buffer, (U32)arguments.count);
+    for(Usize i = 0; i < arguments.count; i += 1) {
+        write_value(buffer, get_key(arguments, i));
+        write_argument(buffer, pool, get_value(arguments, i));
+    }
+}
+
+bool save_ast_cache_entry(
+    const char *directory,
+    const Array<U8> &content,
+    const String_Table &table,
+    const Ast_Pool &pool,
+    const Array<Expression> &expressions,
+    U32 expression_count
+) {
+    // NOTE(llw): Called on parse workers, context.temporary is off limits.
+    auto buffer = create_array<U8>(default_allocator);
+    defer { destroy(buffer); };
+
+    auto header = Ast_Cache_Header {};
+    header.magic              = ast_cache_magic;
+    header.version            = ast_cache_version;
+    header.fixed_string_count = (U32)fixed_string_count;
+    header.string_count       = table.previous_id - (U32)fixed_string_count;
+    header.content_hash       = hash_content(content);
+    header.content_size       = content.count;
+    header.expression_count   = expression_count;
+    header.root_count         = (U32)expressions.count;
+    write_value(buffer, header);
+
+    for(Usize id = fixed_string_count + 1; id <= table.previous_id; id += 1) {
+        auto string = table[(Interned_String)id];
+        write_value(buffer, (U32)string.size);
+        push(buffer, string);
+    }
+
+    for(Usize i = 0; i < expressions.count; i += 1) {
+        write_expression(buffer, pool, expressions[i]);
+    }
+
+    auto size = (U64)buffer.count;
+    copy_bytes(buffer.values + offsetof(Ast_Cache_Header, size), &size, sizeof(size));
+
+    auto body_hash = hash_body(buffer.values + sizeof(Ast_Cache_Header), buffer.count - sizeof(Ast_Cache_Header));
+    copy_bytes(buffer.values + offsetof(Ast_Cache_Header, body_hash), &body_hash, sizeof(body_hash));
+
+    auto path = create_array<U8>(default_allocator);
+    defer { destroy(path); };
+    make_entry_path(directory, header.content_hash, path);
+
+    // NOTE(llw): Entries are never rewritten in place, another worker or
+    //  compiler may have this one mapped. The file is written under a name
+    //  unique to this process and call, then renamed over the entry.
+    static volatile U32 temp_counter = 0;
+    auto temp_path = create_array<U8>(default_allocator);
+    defer { destroy(temp_path); };
+    {
+        char suffix[32];
+        auto size = snprintf(suffix, sizeof(suffix), ".%x-%x.tmp",
+            get_process_id(), atomic_add(&temp_counter, 1)
+        );
+
+        push(temp_path, String { path.values, path.count - 1 });
+        push(temp_path, String { (U8 *)suffix, (Usize)size });
+        push(temp_path, (U8)0);
+    }
+
+    auto temp = (const char *)temp_path.values;
+    if(!write_entire_file(temp, buffer)) {
+        remove(temp);
+        return false;
+    }
+
+    if(!replace_file(temp, (const char *)path.values)) {
+        remove(temp);
+        return false;
+    }
+
+    return true;
+}
+
+
+//
+// RANGE load.
+//
+
+template <typename T>
+static bool read_value(Reader<U8> &reader, T &value) {
+    if((Usize)(reader.end - reader.current) < sizeof(T)) {
+        return false;
+    }
+
+    copy_bytes(&value, reader.current, sizeof(T));
+    reader.current += sizeof(T);
+    return true;
+}
+
+struct Entry_Loader {
+    Reader<U8> reader;
+    Allocator *allocator;
+    Ast_Pool *pool;
+    Interned_String max_string;
+    U32 max_expression;
+};
+
+// NOTE(llw): Every element takes at least this many bytes, bounds counts
+//  before anything is allocated for them.
+static bool check_count(const Entry_Loader &loader, U32 count, Usize min_size) {
+    return (Usize)count*min_size <= (Usize)(loader.reader.end - loader.reader.current);
+}
+
+static bool read_string_id(Entry_Loader &loader, Interned_String &id) {
+    return read_value(loader.reader, id) && id != 0 && id <= loader.max_string;
+}
+
+static bool read_expression(Entry_Loader &loader, Expression &expression);
+
+static bool read_argument(Entry_Loader &loader, Argument &argument) {
+    auto type = (U8)0;
+    if(!read_value(loader.reader, type)) {
+        return false;
+    }
+
+    switch(type) {
+        case ARG_ATOM:
+        case ARG_STRING: {
+            argument.type = (Argument_Type)type;
+            return read_string_id(loader, argument.value);
+        } break;
+
+        case ARG_NUMBER: {
+            argument.type = ARG_NUMBER;
+            return read_string_id(loader, argument.value)
+                && read_value(loader.reader, argument.number);
+        } break;
+
+        case ARG_BLOCK: {
+            auto count = (U32)0;
+            if(!read_value(loader.reader, count) || !check_count(loader, count, 16)) {
+                return false;
+            }
+
+            // NOTE(llw): Children are contiguous, their own blocks come after
+            //  them. Indices, the pool may move while reading them.
+            argument.type = ARG_BLOCK;
+            argument.block = allocate_expressions(*loader.pool, count);
+            for(U32 i = 0; i < count; i += 1) {
+                auto expression = Expression {};
+                if(!read_expression(loader, expression)) {
+                    return false;
+                }
+                loader.pool->expressions[argument.block.first + i] = expression;
+            }
+            return true;
+        } break;
+
+        case ARG_LIST: {
+            auto count = (U32)0;
+            if(!read_value(loader.reader, count) || !check_count(loader, count, 5)) {
+                return false;
+            }
+
+            argument.type = ARG_LIST;
+            argument.list = allocate_arguments(*loader.pool, count);
+            for(U32 i = 0; i < count; i += 1) {
+                auto value = Argument {};
+                if(!read_argument(loader, value)) {
+                    return false;
+                }
+                loader.pool->arguments[argument.list.first + i] = value;
+            }
+            return true;
+        } break;
+
+        default: {
+            return false;
+        } break;
+    }
+}
+
+static bool read_expression(Entry_Loader &loader, Expression &expression) {
+    auto argument_count = (U32)0;
+    auto ok =
+           read_value(loader.reader, expression.id)
+        && read_value(loader.reader, expression.parent)
+        && read_string_id(loader, expression.type)
+        && read_value(loader.reader, argument_count)
+        && expression.id != 0 && expression.id <= loader.max_expression
+        && expression.parent <= loader.max_expression
+        && check_count(loader, argument_count, 9);
+    if(!ok) {
+        return false;
+    }
+
+    expression.arguments = create_argument_map(*loader.allocator);
+    reserve(expression.arguments, argument_count);
+
+    for(U32 i = 0; i < argument_count; i += 1) {
+        auto name = (Interned_String)0;
+        auto value = Argument {};
+        if(!read_string_id(loader, name) || !read_argument(loader, value)) {
+            return false;
+        }
+
+        if(!insert_maybe(expression.arguments, name, value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool load_ast_cache_entry(
+    const char *directory,
+    const Array<U8> &content,
+    String_Table &table,
+    Ast_Pool &pool,
+    Array<Expression> &expressions,
+    U32 &expression_count,
+    Allocator &allocator
+) {
+    assert(table.previous_id == fixed_string_count);
+
+    auto content_hash = hash_content(content);
+
+    auto path = create_array<U8>(default_allocator);
+    defer { destroy(path); };
+    make_entry_path(directory, content_hash, path);
+
+    auto buffer = create_array<U8>(default_allocator);
+    auto mapped = false;
+    if(!map_entire_file((const char *)path.values, buffer, mapped)) {
+        destroy(buffer);
+        return false;
+    }
+    defer {
+        if(mapped) {
+            unmap_file(buffer);
+        }
+        else {
+            destroy(buffer);
+        }
+    };
+
+    auto loader = Entry_Loader {};
+    loader.reader = make_reader(buffer);
+    loader.allocator = &allocator;
+    loader.pool = &pool;
+
+    auto header = Ast_Cache_Header {};
+    auto valid =
+           read_value(loader.reader, header)
+        && header.magic              == ast_cache_magic
+        && header.version            == ast_cache_version
+        && header.fixed_string_count == fixed_string_count
+        && header.content_hash       == content_hash
+        && header.content_size       == content.count
+        && header.size               == buffer.count
+        && header.body_hash          == hash_body(loader.reader.current, buffer.count - sizeof(Ast_Cache_Header))
+        && check_count(loader, header.string_count, 4);
+    if(!valid) {
+        return false;
+    }
+
+    // NOTE(llw): Interning in order gives back the ids they had.
+    for(U32 i = 0; i < header.string_count; i += 1) {
+        auto size = (U32)0;
+        if(    !read_value(loader.reader, size)
+            || (Usize)(loader.reader.end - loader.reader.current) < size
+        ) {
+            return false;
+        }
+
+        auto string = String { (U8 *)loader.reader.current, size };
+        loader.reader.current += size;
+
+        auto id = intern(table, string);
+        if(id != fixed_string_count + 1 + i) {
+            return false;
+        }
+    }
+
+    loader.max_string = table.previous_id;
+    loader.max_expression = header.expression_count;
+
+    if(!check_count(loader, header.root_count, 16)) {
+        return false;
+    }
+
+    reserve(expressions, header.root_count);
+    for(U32 i = 0; i < header.root_count; i += 1) {
+        auto expression = Expression {};
+        if(!read_expression(loader, expression)) {
+            return false;
+        }
+        push(expressions, expression);
+    }
+
+    expression_count = header.expression_count;
+    return loader.reader.current == loader.reader.end;
+}
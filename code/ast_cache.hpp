@@ -0,0 +1,37 @@
+#pragma once
+
+#include "util.hpp"
+#include "parser.hpp"
+
+// NOTE(llw): On disk cache of parsed files, enabled with -cache. An entry
+//  holds what parsing one file produces: the strings of its local string
+//  table in id order and its expressions with local ids, see Parse_Job.
+//  Entries are named by a hash of the source content and ast_cache_version,
+//  so edited files and parser changes miss.
+
+// NOTE(llw): Bump when the parser output or the entry format changes.
+constexpr U32 ast_cache_version = 3;
+
+// NOTE(llw): Thread safe. table must only hold the fixed strings. Returns
+//  false on a miss or an invalid entry; table, pool and expressions are
+//  garbage then.
+bool load_ast_cache_entry(
+    const char *directory,
+    const Array<U8> &content,
+    String_Table &table,
+    Ast_Pool &pool,
+    Array<Expression> &expressions,
+    U32 &expression_count,
+    Allocator &allocator
+);
+
+// NOTE(llw): Thread safe. Failing to save isn't an error, the file is just
+//  parsed again next time.
+bool save_ast_cache_entry(
+    const char *directory,
+    const Array<U8> &content,
+    const String_Table &table,
+    const Ast_Pool &pool,
+    const Array<Expression> &expressions,
+    U32 expression_count
+);
@@ -20,6 +20,18 @@ static void push_quoted(Array<U8> &buffer, Interned_String string) {
     push(buffer, STRING("\""));
 }
 
+// NOTE(llw): From the parsed value, so "1_000" comes out as 1000.
+static void push_number(Array<U8> &buffer, const Argument &number) {
+    assert(number.type == ARG_NUMBER);
+    push_int(buffer, number.number);
+}
+
+static void push_quoted(Array<U8> &buffer, const Argument &number) {
+    push(buffer, STRING("\""));
+    push_number(buffer, number);
+    push(buffer, STRING("\""));
+}
+
 static void push_tn_export(Array<U8> &buffer, Interned_String name) {
     push(buffer, STRING("tn_exports[\""));
     push(buffer, name);
@@ -50,9 +62,11 @@ static void generate_instantiation_js(
 );
 
 void codegen() {
+    STATS_TIME_SCOPE(TIME_CODEGEN);
+    STATS_MEMORY_SCOPE(MEMORY_CODEGEN);
 
     auto instantiate_js = create_array<U8>(context.arena);
-    reserve(instantiate_js, MEBI(1));
+    reserve(instantiate_js, KIBI(64));
 
     push(instantiate_js, STRING("tn_exports = {};\n\n"));
 
@@ -61,10 +75,13 @@ void codegen() {
         auto defines = expr.arguments[context.strings.defines].value;
 
         if(expr.type == context.strings.page) {
+            TRACE_SCOPE("generate_html", defines);
             auto html = generate_html(expr);
             add_output_file(defines, STRING(".html"), html);
         }
         else {
+            TRACE_SCOPE("generate_instantiation_js", defines);
+
             push_tn_export(instantiate_js, defines);
             push(instantiate_js, STRING(" = {};\n"));
 
@@ -100,7 +117,9 @@ void codegen() {
 
 
 
-static void push_list(Array<U8> &buffer, const Array<Argument> &list, String separator) {
+static void push_list(Array<U8> &buffer, const Argument &argument, String separator) {
+    auto list = get_list(argument);
+
     push(buffer, STRING("\""));
     for(Usize i = 0; i < list.count; i += 1) {
         push(buffer, list[i].value);
@@ -177,13 +196,13 @@ static void generate_html(
     auto classes = get_pointer(args, context.strings.classes);
     if(classes != NULL) {
         push(css_string, STRING(" class="));
-        push_list(css_string, classes->list, STRING(" "));
+        push_list(css_string, *classes, STRING(" "));
     }
 
     auto styles = get_pointer(args, context.strings.styles);
     if(styles != NULL) {
         push(css_string, STRING(" style="));
-        push_list(css_string, styles->list, STRING("; "));
+        push_list(css_string, *styles, STRING("; "));
     }
 
 
@@ -209,7 +228,7 @@ static void generate_html(
             return;
         }
 
-        const auto &children = body->block;
+        auto children = get_block(*body);
         for(Usize i = 0; i < children.count; i += 1) {
             generate_html(
                 children[i], parent,
@@ -245,7 +264,7 @@ static void generate_html(
         }
         push(html, STRING(">\n"));
 
-        const auto &options = args[context.strings.options].block;
+        auto options = get_block(args[context.strings.options]);
         for(Usize i = 0; i < options.count; i += 1) {
             generate_html(
                 options[i], parent,
@@ -309,15 +328,18 @@ static void generate_html(
         push(html, STRING(" type="));
         push_quoted(html, type);
         if(initial != NULL) {
-            if(type != context.strings.checkbox) {
+            if(type == context.strings.checkbox) {
+                if(initial->number == 1) {
+                    push(html, STRING(" checked"));
+                }
+            }
+            else if(is_number(initial)) {
                 push(html, STRING(" value="));
-                push_quoted(html, initial->value);
+                push_quoted(html, *initial);
             }
             else {
-                auto value = context.string_table[initial->value];
-                if(value.values[0] == '1') {
-                    push(html, STRING(" checked"));
-                }
+                push(html, STRING(" value="));
+                push_quoted(html, initial->value);
             }
         }
         if(has(args, context.strings.required)) {
@@ -325,11 +347,11 @@ static void generate_html(
         }
         if(min_length != NULL) {
             push       (html, STRING(" minLength="));
-            push_quoted(html, min_length->value);
+            push_quoted(html, *min_length);
         }
         if(max_length != NULL) {
             push       (html, STRING(" maxLength="));
-            push_quoted(html, max_length->value);
+            push_quoted(html, *max_length);
         }
         push(html, STRING(">\n"));
     }
@@ -368,23 +390,19 @@ static void generate_html(
 
     if(expr.type == context.strings.list) {
         auto type_string = args[context.strings.type].value;
-        auto min_string  = intern(context.string_table, STRING("-Infinity"));
-        auto max_string  = intern(context.string_table, STRING("+Infinity"));
-
         auto min = get_pointer(args, context.strings.min);
-        if(min != NULL) { min_string = min->value; }
-
         auto max = get_pointer(args, context.strings.max);
-        if(max != NULL) { max_string = max->value; }
 
         do_indent(init_js, init_js_indent);
         push(init_js, STRING("me.tn_listify("));
         push_tn_export(init_js, type_string);
         push(init_js, STRING(".make"));
         push(init_js, STRING(", "));
-        push(init_js, min_string);
+        if(min != NULL) { push_number(init_js, *min); }
+        else            { push(init_js, STRING("-Infinity")); }
         push(init_js, STRING(", "));
-        push(init_js, max_string);
+        if(max != NULL) { push_number(init_js, *max); }
+        else            { push(init_js, STRING("+Infinity")); }
         push(init_js, STRING(");\n"));
     }
 
@@ -408,10 +426,10 @@ static Array<U8> generate_html(const Expression &page) {
     assert(page.type == context.strings.page);
 
     auto html = create_array<U8>(context.arena);
-    reserve(html, MEBI(1));
+    reserve(html, KIBI(16));
 
     auto init_js = create_array<U8>(context.arena);
-    reserve(init_js, MEBI(1));
+    reserve(init_js, KIBI(16));
 
     push(html, STRING(
         "<!DOCTYPE html>\n"
@@ -441,7 +459,7 @@ static Array<U8> generate_html(const Expression &page) {
 
     auto style_sheets = get_pointer(page.arguments, context.strings.style_sheets);
     if(style_sheets != NULL) {
-        const auto &list = style_sheets->list;
+        auto list = get_list(*style_sheets);
         for(Usize i = 0; i < list.count; i += 1) {
             do_indent(html, 1);
             push(html, STRING("<link rel=\"stylesheet\" href="));
@@ -452,7 +470,7 @@ static Array<U8> generate_html(const Expression &page) {
 
     auto scripts = get_pointer(page.arguments, context.strings.scripts);
     if(scripts != NULL) {
-        const auto &list = scripts->list;
+        auto list = get_list(*scripts);
         for(Usize i = 0; i < list.count; i += 1) {
             do_indent(html, 1);
             push(html, STRING("<script src="));
@@ -478,7 +496,7 @@ static Array<U8> generate_html(const Expression &page) {
     do_indent(init_js, 3);
     push(init_js, STRING("window.page = me;\n"));
 
-    const auto &children = page.arguments[context.strings.body].block;
+    auto children = get_block(page.arguments[context.strings.body]);
     for(Usize i = 0; i < children.count; i += 1) {
         generate_html(
             children[i],
@@ -590,13 +608,13 @@ static void generate_instantiation_js(
         if(styles != NULL) {
             do_indent(buffer, indent);
             push(buffer, STRING("dom.style = "));
-            push_list(buffer, styles->list, STRING("; "));
+            push_list(buffer, *styles, STRING("; "));
             push(buffer, STRING(";\n"));
         }
 
         auto classes = get_pointer(args, context.strings.classes);
         if(classes != NULL) {
-            const auto &list = classes->list;
+            auto list = get_list(*classes);
             for(Usize i = 0; i < list.count; i += 1) {
                 do_indent(buffer, indent);
                 push       (buffer, STRING("dom.classList.add("));
@@ -636,7 +654,7 @@ static void generate_instantiation_js(
     auto write_body = [&]() {
         auto body = get_pointer(args, context.strings.body);
         if(body != NULL) {
-            const auto &children = body->block;
+            auto children = get_block(*body);
             for(Usize i = 0; i < children.count; i += 1) {
                 generate_instantiation_js(
                     children[i],
@@ -683,7 +701,7 @@ static void generate_instantiation_js(
         if(initial) {
             do_indent(buffer, indent);
             push(buffer, STRING("for(let i = 0; i < "));
-            push(buffer, initial->value);
+            push_number(buffer, *initial);
             push(buffer, STRING("; i += 1) {\n"));
 
             do_indent(buffer, indent + 1);
@@ -697,7 +715,7 @@ static void generate_instantiation_js(
         if(min != NULL) {
             do_indent(buffer, indent);
             push(buffer, STRING("me.tn_list_min = "));
-            push(buffer, min->value);
+            push_number(buffer, *min);
             push(buffer, STRING(";\n"));
         }
 
@@ -705,7 +723,7 @@ static void generate_instantiation_js(
         if(max != NULL) {
             do_indent(buffer, indent);
             push(buffer, STRING("me.tn_list_max = "));
-            push(buffer, max->value);
+            push_number(buffer, *max);
             push(buffer, STRING(";\n"));
         }
 
@@ -722,7 +740,7 @@ static void generate_instantiation_js(
 
         write_create_tree_node();
 
-        const auto &options = args[context.strings.options].block;
+        auto options = get_block(args[context.strings.options]);
         for(Usize i = 0; i < options.count; i += 1) {
             const auto &args = options[i].arguments;
 
@@ -804,27 +822,28 @@ static void generate_instantiation_js(
         if(min_length != NULL) {
             do_indent(buffer, indent);
             push(buffer, STRING("dom.minLength = "));
-            push(buffer, min_length->value);
+            push_number(buffer, *min_length);
             push(buffer, STRING(";\n"));
         }
         if(max_length != NULL) {
             do_indent(buffer, indent);
             push(buffer, STRING("dom.maxLength = "));
-            push(buffer, max_length->value);
+            push_number(buffer, *max_length);
             push(buffer, STRING(";\n"));
         }
 
         if(initial != NULL) {
-            if(type != context.strings.checkbox) {
+            if(type == context.strings.checkbox) {
                 do_indent(buffer, indent);
-                push       (buffer, STRING("dom.value = "));
-                push_quoted(buffer, initial->value);
-                push       (buffer, STRING(";\n"));
+                push(buffer, STRING("dom.checked = "));
+                push_number(buffer, *initial);
+                push(buffer, STRING(";\n"));
             }
             else {
                 do_indent(buffer, indent);
-                push(buffer, STRING("dom.checked = "));
-                push(buffer, initial->value);
+                push(buffer, STRING("dom.value = "));
+                if(is_number(initial)) { push_quoted(buffer, *initial); }
+                else                   { push_quoted(buffer, initial->value); }
                 push(buffer, STRING(";\n"));
             }
         }
@@ -1,4 +1,5 @@
 #include "context.hpp"
+#include "scan.hpp"
 
 #include <stdio.h>
 
@@ -14,12 +15,30 @@ const char *argument_type_strings[ARG_LIST + 1] = {
 
 void setup_context() {
     context = {};
-
-    context.arena        = create_arena();
-    context.temporary    = create_arena();
+    context.stats.hash_grow_base = hash_grow_count;
+    context.trace.base_ns = get_time_ns();
+    context.trace.events  = { &default_allocator };
+    context.stats.memory_trackers = { &default_allocator };
+    select_scan_procs();
+
+    // NOTE(llw): Virtual, so the last allocation can always grow in place
+    //  and there are no partially used blocks.
+    context.arena        = create_virtual_arena();
+    context.temporary    = create_virtual_arena();
     context.string_table = create_string_table(context.arena);
+
+    context.ast_expression_arena = create_virtual_arena();
+    context.ast_argument_arena   = create_virtual_arena();
+    context.ast = create_ast_pool(context.ast_expression_arena, context.ast_argument_arena);
+    init_mutex(context.ast_lock);
+
+    context.worker_arenas = { &context.arena };
+
     context.expressions  = { &context.arena };
     context.symbols      = create_map<Interned_String, Symbol>(context.arena);
+    context.instances    = { &context.arena };
+    context.instance_table = create_map<U64, Usize>(context.arena);
+    init_mutex(context.instance_lock);
     context.exports      = { &context.arena };
 
     context.sources       = { &context.arena };
@@ -27,106 +46,93 @@ void setup_context() {
     context.outputs       = { &context.arena };
     context.referenced_files.allocator = &context.arena;
 
-    context.strings.empty_string = intern(context.string_table, STRING(""));
-
-    context.strings.dot    = intern(context.string_table, STRING("."));
-    context.strings.comma  = intern(context.string_table, STRING(","));
-    context.strings.colon  = intern(context.string_table, STRING(":"));
-    context.strings.paren_open  = intern(context.string_table, STRING("("));
-    context.strings.paren_close = intern(context.string_table, STRING(")"));
-    context.strings.curly_open  = intern(context.string_table, STRING("{"));
-    context.strings.curly_close = intern(context.string_table, STRING("}"));
-    context.strings.square_open  = intern(context.string_table, STRING("["));
-    context.strings.square_close = intern(context.string_table, STRING("]"));
+    intern_fixed_strings(context.string_table);
 
-    auto &strings = context.strings;
-    auto &table = context.string_table;
-
-    strings.id        = intern(table, STRING("id"));
-
-    strings.defines  = intern(table, STRING("defines"));
-    strings.inherits = intern(table, STRING("inherits"));
+    auto ids = (Interned_String *)&context.strings;
+    static_assert(sizeof(context.strings) == fixed_string_count*sizeof(Interned_String), "");
 
-    strings.body = intern(table, STRING("body"));
-    strings.type  = intern(table, STRING("type"));
-    strings.value = intern(table, STRING("value"));
+    for(Usize i = 0; i < fixed_string_count; i += 1) {
+        ids[i] = (Interned_String)(i + 1);
+    }
 
-    strings.classes = intern(table, STRING("classes"));
-    strings.styles  = intern(table, STRING("styles"));
+    auto &strings = context.strings;
 
-    strings.desktop = intern(table, STRING("desktop"));
-    strings.mobile  = intern(table, STRING("mobile"));
+    context.simple_types.allocator = &context.arena;
+    insert(context.simple_types, strings.h1, 0);
+    insert(context.simple_types, strings.p, 0);
+    insert(context.simple_types, strings.span, 0);
+    insert(context.simple_types, strings.button, 0);
+    insert(context.simple_types, strings.textarea, 0);
 
-    strings.page = intern(table, STRING("page"));
-    strings.title        = intern(table, STRING("title"));
-    strings.icon         = intern(table, STRING("icon"));
-    strings.style_sheets = intern(table, STRING("style_sheets"));
-    strings.scripts      = intern(table, STRING("scripts"));
+    context.deploy_file_prefix = context.strings.empty_string;
+}
 
-    strings.text   = intern(table, STRING("text"));
-    strings.div    = intern(table, STRING("div"));
-    strings.list   = intern(table, STRING("list"));
+void destroy_context() {
+    destroy(context.trace.events);
+    destroy_memory_trackers(context.stats);
 
-    strings.h1   = intern(table, STRING("h1"));
-    strings.p    = intern(table, STRING("p"));
-    strings.span = intern(table, STRING("span"));
+    for(Usize i = 0; i < context.sources.count; i += 1) {
+        release_source(context.sources[i]);
+    }
 
-    strings.parameters = intern(table, STRING("parameters"));
+    for(Usize i = 0; i < context.worker_arenas.count; i += 1) {
+        destroy(*context.worker_arenas[i]);
+    }
 
-    strings.form = intern(table, STRING("form"));
+    destroy(context.ast_expression_arena);
+    destroy(context.ast_argument_arena);
+    destroy_mutex(context.ast_lock);
+    destroy_mutex(context.instance_lock);
 
-    strings.label = intern(table, STRING("label"));
-    strings.input = intern(table, STRING("input"));
-    strings.button = intern(table, STRING("button"));
-    strings.textarea = intern(table, STRING("textarea"));
+    // NOTE(llw): Everything else lives in these two.
+    destroy(context.arena);
+    destroy(context.temporary);
+    context = {};
+}
 
-    strings._for = intern(table, STRING("for"));
+Usize get_arena_bytes_used() {
+    auto result = get_total_used(context.arena)
+        + get_total_used(context.ast_expression_arena)
+        + get_total_used(context.ast_argument_arena);
 
-    strings.min     = intern(table, STRING("min"));
-    strings.max     = intern(table, STRING("max"));
-    strings.locked  = intern(table, STRING("locked"));
-    strings.initial = intern(table, STRING("initial"));
+    for(Usize i = 0; i < context.worker_arenas.count; i += 1) {
+        result += get_total_used(*context.worker_arenas[i]);
+    }
 
-    strings.email  = intern(table, STRING("email"));
-    strings.number = intern(table, STRING("number"));
-    strings.date   = intern(table, STRING("date"));
-    strings.time   = intern(table, STRING("time"));
-    strings.checkbox = intern(table, STRING("checkbox"));
-    strings.file     = intern(table, STRING("file"));
+    return result;
+}
 
-    strings.select  = intern(table, STRING("select"));
-    strings.option  = intern(table, STRING("option"));
-    strings.options = intern(table, STRING("options"));
+Usize get_worker_count(Usize job_count) {
+    auto result = context.thread_count;
+    if(result == 0) {
+        result = get_processor_count();
+    }
+    return max(min(result, job_count), (Usize)1);
+}
 
-    strings.anchor = intern(table, STRING("anchor"));
-    strings.href   = intern(table, STRING("href"));
+void reserve_worker_arenas(Usize count) {
+    while(context.worker_arenas.count < count) {
+        auto arena = allocate<Arena>(context.arena);
+        *arena = create_virtual_arena();
+        push(context.worker_arenas, arena);
 
-    strings.required   = intern(table, STRING("required"));
-    strings.min_length = intern(table, STRING("min_length"));
-    strings.max_length = intern(table, STRING("max_length"));
+        if(context.print_memory_stats) {
+            track_arena(context.stats, *arena);
+        }
+    }
+}
 
+void intern_fixed_strings(String_Table &table) {
+    assert(table.previous_id == 0);
 
-    TEMP_SCOPE(context.temporary);
+    for(Usize i = 0; i < fixed_string_count; i += 1) {
+        auto string = String { (U8 *)fixed_strings[i].values, fixed_strings[i].size };
+        auto id = intern(table, string);
 
-    auto set = create_map<Interned_String, int>(context.temporary);
-    auto ids = (Interned_String *)&context.strings;
-    for(Usize i = 0;
-        i < sizeof(context.strings)/sizeof(Interned_String);
-        i += 1
-    ) {
-        auto id = ids[i];
-        assert(id != 0);
-        assert(insert_maybe(set, id, 0));
+        // NOTE(llw): The tokenizer relies on this, see lookup_fixed_string.
+        assert(id == i + 1);
+        UNUSED(id);
     }
-
-    context.simple_types.allocator = &context.arena;
-    insert(context.simple_types, strings.h1, 0);
-    insert(context.simple_types, strings.p, 0);
-    insert(context.simple_types, strings.span, 0);
-    insert(context.simple_types, strings.button, 0);
-    insert(context.simple_types, strings.textarea, 0);
-
-    context.deploy_file_prefix = context.strings.empty_string;
 }
 
 
@@ -158,15 +164,18 @@ String get_id_identifier(Interned_String id, Id_Type *id_type) {
     return ident;
 }
 
-Interned_String make_full_id(Interned_String prefix, String id, Id_Type id_type) {
+Interned_String make_full_id(
+    String_Table &table, Arena &temporary,
+    Interned_String prefix, String id, Id_Type id_type
+) {
     auto result = Interned_String {};
 
     if(prefix != 0) {
-        TEMP_SCOPE(context.temporary);
-        auto buffer = create_array<U8>(context.temporary);
+        TEMP_SCOPE(temporary);
+        auto buffer = create_array<U8>(temporary);
 
         if(id_type == ID_LOCAL) {
-            push(buffer, prefix);
+            push(buffer, table[prefix]);
             push(buffer, STRING("-"));
         }
         else if(id_type == ID_GLOBAL) {
@@ -178,12 +187,17 @@ Interned_String make_full_id(Interned_String prefix, String id, Id_Type id_type)
 
         push(buffer, id);
 
-        result = intern(context.string_table, str(buffer));
+        result = intern(table, str(buffer));
     }
 
     return result;
 }
 
+Interned_String make_full_id(Interned_String prefix, String id, Id_Type id_type) {
+    auto result = make_full_id(context.string_table, context.temporary, prefix, id, id_type);
+    return result;
+}
+
 Interned_String make_full_id(Interned_String prefix, Interned_String id) {
     Id_Type type;
     auto ident = get_id_identifier(id, &type);
@@ -229,7 +243,61 @@ bool parse_arguments(int argument_count, const char **arguments) {
                 return false;
             }
 
-            if(string[1] == 'i') {
+            if(strcmp(string, "-stats") == 0) {
+                context.print_stats = true;
+            }
+            else if(strcmp(string, "-memory") == 0) {
+                if(!context.print_memory_stats) {
+                    context.print_memory_stats = true;
+                    track_arena(context.stats, context.arena);
+                    track_arena(context.stats, context.ast_expression_arena);
+                    track_arena(context.stats, context.ast_argument_arena);
+                }
+            }
+            else if(strcmp(string, "-no-simd") == 0) {
+                select_scan_procs(false);
+            }
+            else if(strcmp(string, "-threads") == 0) {
+                i += 1;
+                auto count = (U64)0;
+                if(    i >= argument_count
+                    || !parse_int_maybe(String { (U8 *)arguments[i], strlen(arguments[i]) }, count)
+                ) {
+                    printf("'-threads' requires a number.\n");
+                    return false;
+                }
+
+                context.thread_count = (Usize)count;
+            }
+            else if(strcmp(string, "-cache") == 0) {
+                i += 1;
+                if(i >= argument_count) {
+                    printf("'-cache' requires an argument.\n");
+                    return false;
+                }
+
+                context.cache_path = intern_path(arguments[i]);
+            }
+            else if(strcmp(string, "-stats-json") == 0) {
+                i += 1;
+                if(i >= argument_count) {
+                    printf("'-stats-json' requires an argument.\n");
+                    return false;
+                }
+
+                context.stats_json_path = intern(context.string_table, arguments[i]);
+            }
+            else if(strcmp(string, "-trace") == 0) {
+                i += 1;
+                if(i >= argument_count) {
+                    printf("'-trace' requires an argument.\n");
+                    return false;
+                }
+
+                context.trace_path = intern(context.string_table, arguments[i]);
+                context.trace.enabled = true;
+            }
+            else if(string[1] == 'i') {
                 i += 1;
                 if(i >= argument_count) {
                     printf("'-i' requires an argument.\n");
@@ -288,6 +356,9 @@ bool parse_arguments(int argument_count, const char **arguments) {
 }
 
 bool read_sources() {
+    STATS_TIME_SCOPE(TIME_READ_SOURCES);
+    STATS_MEMORY_SCOPE(MEMORY_READ_SOURCES);
+
     for(Usize i = 0; i < context.sources.count; i += 1) {
         auto &source = context.sources[i];
 
@@ -300,15 +371,26 @@ bool read_sources() {
 
         auto path_string = context.string_table[path].values;
         auto buffer = create_array<U8>(context.arena);
-        if(!read_entire_file((char *)path_string, buffer)) {
+        auto mapped = false;
+        if(!map_entire_file((char *)path_string, buffer, mapped)) {
             printf("Error: reading file %s\n", path_string);
             return false;
         }
 
         source.file_path = path;
         source.content = buffer;
+        source.is_mapped = mapped;
+
+        STATS_COUNT(COUNT_SOURCE_BYTES, buffer.count);
     }
 
     return true;
 }
 
+void release_source(Source &source) {
+    if(source.is_mapped) {
+        unmap_file(source.content);
+        source.is_mapped = false;
+    }
+}
+
@@ -3,15 +3,64 @@
 #include "util.hpp"
 #include "parser.hpp"
 #include "analyzer.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 
 #include <libcpp/memory/arena.hpp>
+#include <libcpp/util/thread.hpp>
 using namespace libcpp;
 
 struct Source {
     Interned_String file_path;
     Array<U8> content;
+    // NOTE(llw): content is a file mapping, see release_source.
+    bool is_mapped;
 };
 
+// NOTE(llw): The fixed vocabulary. setup_context interns these first and in
+//  order, so the i-th one has id i + 1 and the tokenizer can map them to
+//  their ids without interning.
+#define FIXED_STRINGS(X)                                                    \
+    X(empty_string, "")                                                     \
+    X(dot, ".") X(comma, ",") X(colon, ":")                                 \
+    X(paren_open, "(") X(paren_close, ")")                                  \
+    X(curly_open, "{") X(curly_close, "}")                                  \
+    X(square_open, "[") X(square_close, "]")                                \
+    X(id, "id")                                                             \
+    X(defines, "defines") X(inherits, "inherits")                           \
+    X(body, "body") X(type, "type") X(value, "value")                       \
+    X(classes, "classes") X(styles, "styles")                               \
+    X(desktop, "desktop") X(mobile, "mobile")                               \
+    X(page, "page") X(title, "title") X(icon, "icon")                       \
+    X(style_sheets, "style_sheets") X(scripts, "scripts")                   \
+    X(text, "text") X(div, "div") X(list, "list")                           \
+    X(h1, "h1") X(p, "p") X(span, "span")                                   \
+    X(parameters, "parameters")                                             \
+    X(form, "form")                                                         \
+    X(label, "label") X(input, "input")                                     \
+    X(button, "button") X(textarea, "textarea")                             \
+    X(_for, "for")                                                          \
+    X(min, "min") X(max, "max") X(locked, "locked") X(initial, "initial")   \
+    X(email, "email") X(number, "number") X(date, "date") X(time, "time")   \
+    X(checkbox, "checkbox") X(file, "file")                                 \
+    X(select, "select") X(option, "option") X(options, "options")           \
+    X(anchor, "anchor") X(href, "href")                                     \
+    X(required, "required")                                                 \
+    X(min_length, "min_length") X(max_length, "max_length")
+
+struct Fixed_String {
+    const char *values;
+    Usize size;
+};
+
+constexpr Fixed_String fixed_strings[] = {
+    #define X(name, string) { string, sizeof(string) - 1 },
+    FIXED_STRINGS(X)
+    #undef X
+};
+
+constexpr Usize fixed_string_count = sizeof(fixed_strings)/sizeof(fixed_strings[0]);
+
 extern struct Context {
 
     Arena temporary;
@@ -19,40 +68,41 @@ extern struct Context {
 
     String_Table string_table;
     struct {
-        Interned_String
-            empty_string,
-            dot, comma, colon,
-            paren_open, paren_close,
-            curly_open, curly_close,
-            square_open, square_close,
-            id,
-            defines, inherits,
-            body, type, value,
-            classes, styles,
-            desktop, mobile,
-            page, title, icon, style_sheets, scripts,
-            text, div, list,
-            h1, p, span,
-            parameters,
-            form,
-            label, input, button, textarea,
-            _for,
-            min, max, locked, initial,
-            email, number, date, time, checkbox, file,
-            select, option, options,
-            anchor, href,
-            required, min_length, max_length;
+        #define X(name, string) Interned_String name;
+        FIXED_STRINGS(X)
+        #undef X
     } strings;
 
     Map<Interned_String, int> simple_types;
 
 
+    // NOTE(llw): Blocks and lists of all expressions, see Ast_Pool.
+    Ast_Pool ast;
+    Arena ast_expression_arena;
+    Arena ast_argument_arena;
+    // NOTE(llw): ast.lock while several threads instantiate.
+    Mutex ast_lock;
+
+    // NOTE(llw): 0 is one per processor.
+    Usize thread_count;
+    // NOTE(llw): One per worker thread, they own what is allocated on it
+    //  (parsed expressions, instances). Allocated one by one, parsed argument
+    //  maps point at them, so they must not move when more are added.
+    Array<Arena *> worker_arenas;
+
     // Parser
     U32 next_expression_id;
     Array<Expression> expressions;
+    // NOTE(llw): Directory of the ast cache, 0 if disabled. See ast_cache.hpp.
+    Interned_String cache_path;
 
     // Analyzer
     Map<Interned_String, Symbol> symbols;
+    // NOTE(llw): Index into instances by hash of the symbol and its
+    //  parameter values.
+    Array<Symbol_Instance> instances;
+    Map<U64, Usize> instance_table;
+    Mutex instance_lock;
 
     Array<Expression *> exports;
 
@@ -64,14 +114,46 @@ extern struct Context {
     Map<Interned_String, int> referenced_files;
     Interned_String deploy_file_prefix;
 
+    // Stats
+    Stats stats;
+    bool print_stats;
+    bool print_memory_stats;
+    Interned_String stats_json_path;
+
+    Trace trace;
+    Interned_String trace_path;
+
 } context;
 
 void setup_context();
+void destroy_context();
+
+// NOTE(llw): Interns fixed_strings into an empty table, so they get their
+//  fixed ids.
+void intern_fixed_strings(String_Table &table);
 
 _inline void push(Array<U8> &array, Interned_String id) {
     push(array, context.string_table[id]);
 }
 
+_inline Ast_Slice<Expression> get_block(const Argument &argument) {
+    return get_block(context.ast, argument);
+}
+
+_inline Ast_Slice<Argument> get_list(const Argument &argument) {
+    return get_list(context.ast, argument);
+}
+
+// NOTE(llw): Bytes used by context.arena, context.ast and the worker arenas.
+Usize get_arena_bytes_used();
+
+// NOTE(llw): Threads to run job_count jobs on, from context.thread_count.
+//  At least 1.
+Usize get_worker_count(Usize job_count);
+
+// NOTE(llw): Makes sure there are count worker arenas.
+void reserve_worker_arenas(Usize count);
+
 
 enum Id_Type {
     ID_LOCAL,
@@ -83,9 +165,18 @@ String get_id_identifier(Interned_String id, Id_Type *id_type);
 
 Interned_String make_full_id(Interned_String prefix, String id, Id_Type id_type);
 
+// NOTE(llw): Into table, prefix is from table. Uses temporary, not the
+//  context, so threads can use their own.
+Interned_String make_full_id(
+    String_Table &table, Arena &temporary,
+    Interned_String prefix, String id, Id_Type id_type
+);
+
 Interned_String make_full_id(Interned_String prefix, Interned_String id);
 
 
 bool parse_arguments(int argument_count, const char **arguments);
 bool read_sources();
+// NOTE(llw): Frees the content of mapped sources. Safe to call on any source.
+void release_source(Source &source);
 
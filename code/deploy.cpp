@@ -6,12 +6,16 @@
 #include "../build/runtime.inl"
 
 bool deploy() {
+    STATS_TIME_SCOPE(TIME_DEPLOY);
+    STATS_MEMORY_SCOPE(MEMORY_DEPLOY);
 
     // NOTE(llw): Copy referenced files.
     for(Usize i = 0; i < context.referenced_files.count; i += 1) {
         auto name = context.referenced_files.entries[i].key;
         auto name_string = context.string_table[name];
 
+        TRACE_SCOPE("copy_file", name);
+
         auto path = find_first_file(context.include_paths, name_string);
         if(path == 0) {
             printf("Error: Could not find referenced file '%s'.\n", name_string.values);
@@ -37,6 +41,9 @@ bool deploy() {
             printf("Error: Could not write file '%s'.\n", out_string);
             return false;
         }
+
+        STATS_COUNT(COUNT_OUTPUT_FILES, 1);
+        STATS_COUNT(COUNT_OUTPUT_BYTES, buffer.count);
     }
 
     // NOTE(llw): Write output files.
@@ -44,15 +51,22 @@ bool deploy() {
         auto source = context.outputs[i];
         auto path = (char *)context.string_table[source.file_path].values;
 
+        TRACE_SCOPE("write_file", source.file_path);
+
         if(!write_entire_file(path, source.content)) {
             printf("Error: Could not write file '%s'\n", path);
             return false;
         }
+
+        STATS_COUNT(COUNT_OUTPUT_FILES, 1);
+        STATS_COUNT(COUNT_OUTPUT_BYTES, source.content.count);
     }
 
 
     // NOTE(llw): Write runtime.
     {
+        TRACE_SCOPE("write_file", 0);
+
         auto buffer = Array<U8> {};
         buffer.values = runtime;
         buffer.count  = runtime_size;
@@ -68,6 +82,9 @@ bool deploy() {
             printf("Error: Could not write file '%s'.\n", out_string);
             return false;
         }
+
+        STATS_COUNT(COUNT_OUTPUT_FILES, 1);
+        STATS_COUNT(COUNT_OUTPUT_BYTES, buffer.count);
     }
 
     return true;
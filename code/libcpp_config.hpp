@@ -1,3 +1,5 @@
 #define LIBCPP_ENABLE_ASSERT 1
 #define DLIBCPP_USE_LIBC 1
 
+// NOTE(llw): -memory tracks every worker arena.
+#define LIBCPP_TRACKING_MAX_TARGETS 256
@@ -27,27 +27,70 @@ int main(int argument_count, const char **arguments) {
         return 1;
     }
 
-    if(!read_sources()) {
-        return 1;
+    {
+        TRACE_SCOPE("read_sources", 0);
+        if(!read_sources()) {
+            return 1;
+        }
     }
 
-    for(Usize i = 0; i < context.sources.count; i += 1) {
-        if(!parse(context.sources[i].content)) {
+    {
+        TRACE_SCOPE("parse", 0);
+        STATS_TIME_SCOPE(TIME_PARSE);
+        STATS_MEMORY_SCOPE(MEMORY_PARSE);
+
+        if(!parse_sources()) {
             return 1;
         }
     }
 
-    if(!analyze()) {
-        return 1;
+    {
+        TRACE_SCOPE("analyze", 0);
+        if(!analyze()) {
+            return 1;
+        }
     }
 
-    codegen();
+    {
+        TRACE_SCOPE("codegen", 0);
+        codegen();
+    }
 
-    if(!deploy()) {
-        return 1;
+    {
+        TRACE_SCOPE("deploy", 0);
+        if(!deploy()) {
+            return 1;
+        }
     }
 
     printf("Done.\n");
+
+    finish_stats(context.stats);
+
+    if(context.print_stats) {
+        print_stats(context.stats);
+    }
+
+    if(context.print_memory_stats) {
+        print_memory_stats(context.stats);
+    }
+
+    if(context.stats_json_path != 0) {
+        auto path = (const char *)context.string_table[context.stats_json_path].values;
+        if(!write_stats_json(context.stats, path)) {
+            printf("Error: Could not write stats to '%s'.\n", path);
+            return 1;
+        }
+    }
+
+    if(context.trace_path != 0) {
+        auto path = (const char *)context.string_table[context.trace_path].values;
+        if(!write_trace_json(context.trace, path)) {
+            printf("Error: Could not write trace to '%s'.\n", path);
+            return 1;
+        }
+    }
+
     return 0;
 }
 
@@ -1,13 +1,20 @@
 #include "parser.hpp"
 #include "context.hpp"
+#include "scan.hpp"
+#include "ast_cache.hpp"
+
+#include <libcpp/util/thread.hpp>
+#include <libcpp/util/defer.hpp>
 
 #include <cstdio>
+#include <cstring>
+#include <cstdarg>
 
 //
 // RANGE tokenizer.
 //
 
-enum Token_Type {
+enum Token_Type : U8 {
     TOKEN_ATOM,
     TOKEN_STRING,
     TOKEN_NUMBER,
@@ -15,194 +22,468 @@ enum Token_Type {
     TOKEN_OTHER,
 };
 
+// NOTE(llw): Line and column aren't stored, see get_source_location. A
+//  TOKEN_EOL stands for any number of line breaks.
 struct Token {
+    U32 source_offset;
+    union {
+        U32 source_size;
+        // NOTE(llw): TOKEN_NUMBER, so the digits are only parsed once.
+        U32 number;
+    };
     Interned_String string;
+    Token_Type type;
+};
 
-    Unsigned source_line;
-    Unsigned source_column;
-    Unsigned source_size;
+static_assert(sizeof(Token) == 16, "");
 
-    Token_Type type;
+// NOTE(llw): Only for diagnostics, so there is no line index. Columns are in
+//  bytes, starting at 1.
+static void get_source_location(
+    const U8 *source, U32 offset,
+    Unsigned &line, Unsigned &column
+) {
+    line = 1;
+    auto line_begin = (U32)0;
+    for(U32 i = 0; i < offset; i += 1) {
+        if(source[i] == '\n') {
+            line += 1;
+            line_begin = i + 1;
+        }
+    }
+    column = offset - line_begin + 1;
+}
+
+// NOTE(llw): Character classes for the tokenizer. The low bits are the class
+//  of a byte at the start of a token, the high bits say which tokens the byte
+//  can continue. One lookup per byte.
+enum Char_Class : U8 {
+    CHAR_OTHER      = 0,
+    CHAR_WHITESPACE = 1,
+    CHAR_ATOM       = 2,
+    CHAR_DIGIT      = 3,
+    CHAR_QUOTE      = 4,
+    CHAR_SLASH      = 5,
+    CHAR_CLASS_MASK = 0x0f,
+
+    CHAR_IN_ATOM    = 0x10,
+    CHAR_IN_NUMBER  = 0x20,
 };
 
+struct Char_Table {
+    U8 entries[256];
+};
+
+static constexpr Char_Table make_char_table() {
+    auto result = Char_Table {};
+
+    for(Usize c = 0; c < 256; c += 1) {
+        auto entry = (U8)CHAR_OTHER;
+
+        if(c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            entry = CHAR_WHITESPACE;
+        }
+        else if(c >= 'A' && c <= 'Z' || c >= 'a' && c <= 'z' || c == '_') {
+            entry = CHAR_ATOM | CHAR_IN_ATOM;
+        }
+        else if(c >= '0' && c <= '9') {
+            entry = CHAR_DIGIT | CHAR_IN_ATOM | CHAR_IN_NUMBER;
+        }
+        else if(c == '"') {
+            entry = CHAR_QUOTE;
+        }
+        else if(c == '/') {
+            entry = CHAR_SLASH;
+        }
+
+        result.entries[c] = entry;
+    }
+
+    // NOTE(llw): '_' separates digits in numbers.
+    result.entries['_'] |= CHAR_IN_NUMBER;
+
+    return result;
+}
+
+static constexpr Char_Table char_table = make_char_table();
+
+static_assert((char_table.entries['a'] & CHAR_CLASS_MASK) == CHAR_ATOM, "");
+static_assert((char_table.entries['7'] & CHAR_IN_ATOM) != 0, "");
+static_assert((char_table.entries['_'] & CHAR_IN_NUMBER) != 0, "");
+
+// NOTE(llw): Perfect hash over fixed_strings, found at compile time. Maps
+//  punctuation and keywords to their fixed ids without touching the string
+//  table.
+template <typename T>
+static constexpr U32 hash_fixed_string(U32 seed, const T *values, Usize size) {
+    // NOTE(llw): fnv-1a with a seeded basis.
+    auto hash = (U32)2166136261u ^ seed;
+    for(Usize i = 0; i < size; i += 1) {
+        hash ^= (U8)values[i];
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+struct Fixed_String_Table {
+    static constexpr Usize size = 512;
+
+    U32 seed;
+    // NOTE(llw): 0 if empty, the id otherwise.
+    U8 ids[size];
+};
+
+static_assert(fixed_string_count < 256, "Fixed_String_Table::ids is U8.");
+
+static constexpr Fixed_String_Table make_fixed_string_table() {
+    for(U32 seed = 1; seed < 1000; seed += 1) {
+        auto result = Fixed_String_Table {};
+        result.seed = seed;
+
+        // NOTE(llw): Skips empty_string, there are no empty tokens.
+        auto collision = false;
+        for(Usize i = 1; i < fixed_string_count && !collision; i += 1) {
+            const auto &fixed = fixed_strings[i];
+            auto slot = hash_fixed_string(seed, fixed.values, fixed.size) % Fixed_String_Table::size;
+
+            collision = result.ids[slot] != 0;
+            result.ids[slot] = (U8)(i + 1);
+        }
+
+        if(!collision) {
+            return result;
+        }
+    }
+
+    return {};
+}
+
+static constexpr Fixed_String_Table fixed_string_table = make_fixed_string_table();
+
+static_assert(fixed_string_table.seed != 0, "No perfect hash found, grow the table.");
+
+static _inline Interned_String lookup_fixed_string(const U8 *begin, const U8 *end) {
+    auto size = (Usize)(end - begin);
+    auto slot = hash_fixed_string(fixed_string_table.seed, begin, size) % Fixed_String_Table::size;
+
+    auto id = (Interned_String)fixed_string_table.ids[slot];
+    if(id == 0) {
+        return 0;
+    }
+
+    const auto &fixed = fixed_strings[id - 1];
+    if(fixed.size != size || memcmp(fixed.values, begin, size) != 0) {
+        return 0;
+    }
+
+    return id;
+}
+
+// NOTE(llw): Advances while the bytes have any of flags set.
+static _inline void skip_class(Reader<U8> &reader, U8 flags) {
+    while(    reader.current < reader.end
+        && (char_table.entries[*reader.current] & flags) != 0
+    ) {
+        reader.current += 1;
+    }
+}
+
 static void skip_whitespace(
     Reader<U8> &reader,
     Unsigned &current_line, const U8 *&line_begin
 ) {
     while(reader.current < reader.end) {
-        // NOTE(llw): Single line comment.
-        if(    reader.current[0] == '/'
-            && reader.current + 1 < reader.end
-            && reader.current[1] == '/'
-        ) {
-            reader.current += 2;
-
-            while(reader.current < reader.end) {
-                auto at = *reader.current;
-                if(at == '\n') {
-                    break;
-                }
+        auto char_class = char_table.entries[*reader.current] & CHAR_CLASS_MASK;
 
-                reader.current += 1;
-            }
+        if(char_class == CHAR_WHITESPACE) {
+            reader.current = scan_procs.skip_whitespace(
+                reader.current, reader.end,
+                current_line, line_begin
+            );
         }
-
-        auto at = *reader.current;
-        if(    at != ' '
-            && at != '\t'
-            && at != '\r'
-            && at != '\n'
+        // NOTE(llw): Single line comment. The '\n' is left for the next
+        //  iteration, so it is counted.
+        else if(   char_class == CHAR_SLASH
+                && reader.current + 1 < reader.end
+                && reader.current[1] == '/'
         ) {
+            reader.current = scan_procs.find_either(
+                reader.current + 2, reader.end,
+                '\n', '\n'
+            );
+        }
+        else {
             break;
         }
+    }
+}
 
-        if(at == '\n') {
-            current_line += 1;
-            line_begin = reader.current + 1;
-        }
 
-        reader.current += 1;
-    }
+
+
+// NOTE(llw): Pull based tokenizer. The parser never looks further ahead than
+//  three tokens, so instead of an array with all tokens of the file, they
+//  live in a small ring buffer that is refilled on demand.
+struct Token_Stream {
+    static constexpr Usize ring_size = 4;
+
+    const U8 *source;
+    Reader<U8> reader;
+    String_Table *string_table;
+
+    // NOTE(llw): TOKEN_EOLs that still have to be handed out.
+    U8 pending_eols;
+    bool reached_end;
+    bool failed;
+
+    // NOTE(llw): Of the first error of the tokenizer or the parser. Printed
+    //  by the caller, files are parsed on any thread, see parse_sources.
+    char error[128];
+
+    Token ring[ring_size];
+    Usize ring_begin;
+    Usize ring_count;
+
+    Usize token_count;
+};
+
+static Token_Stream make_token_stream(String_Table &string_table, const Array<U8> &buffer) {
+    auto result = Token_Stream {};
+    result.source = buffer.values;
+    result.reader = make_reader(buffer);
+    result.string_table = &string_table;
+    return result;
 }
 
+static bool parse_error(Token_Stream &stream, const char *format, ...) {
+    if(stream.error[0] == 0) {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(stream.error, sizeof(stream.error), format, args);
+        va_end(args);
+    }
+    return false;
+}
 
+// NOTE(llw): Returns false at the end of the source or on error, failed is
+//  set then.
+static bool next_token(Token_Stream &stream, Token &token) {
+    auto &reader = stream.reader;
 
+    if(stream.pending_eols > 0) {
+        stream.pending_eols -= 1;
+        token = Token {};
+        token.type = TOKEN_EOL;
+        return true;
+    }
 
-static bool tokenize(
-    String_Table &string_table,
-    const Array<U8> &buffer,
-    Array<Token> &result
-) {
-    auto reader = make_reader(buffer);
+    if(stream.reached_end || stream.failed) {
+        return false;
+    }
 
-    auto source_line = (Unsigned)1;
+    // NOTE(llw): One call skips all whitespace and comments between two
+    //  tokens, so consecutive line breaks become a single TOKEN_EOL.
+    auto line_count = (Unsigned)0;
     auto line_begin = reader.current;
+    skip_whitespace(reader, line_count, line_begin);
 
-    while(true) {
-        auto old_source_line = source_line;
-        skip_whitespace(reader, source_line, line_begin);
-        if(reader.current >= reader.end) {
-            break;
-        }
+    if(reader.current >= reader.end) {
+        // NOTE(llw): Extra tokens for lookahead.
+        stream.reached_end = true;
+        stream.pending_eols = 2;
+        return next_token(stream, token);
+    }
 
-        for(auto l = old_source_line; l < source_line; l += 1) {
-            auto eol = Token {};
-            eol.type = TOKEN_EOL;
-            push(result, eol);
-        }
+    // NOTE(llw): The reader stays at the token, so the next call skips
+    //  nothing and produces it.
+    if(line_count > 0) {
+        stream.pending_eols = 1;
+        return next_token(stream, token);
+    }
 
-        auto token_begin = reader.current;
+    auto token_begin = reader.current;
 
-        auto token = Token {};
-        token.source_line = source_line;
-        token.source_column = (Unsigned)(token_begin - line_begin) + 1;
+    token = Token {};
+    token.source_offset = (U32)(token_begin - stream.source);
 
-        auto at = *reader.current;
-        reader.current += 1;
+    auto at = *reader.current;
+    reader.current += 1;
 
-        if(is_alpha(at) || at == '_') {
-            // atom.
+    switch(char_table.entries[at] & CHAR_CLASS_MASK) {
+        case CHAR_ATOM: {
+            skip_class(reader, CHAR_IN_ATOM);
+            token.string = lookup_fixed_string(token_begin, reader.current);
+            token.type = TOKEN_ATOM;
+        } break;
+
+        case CHAR_DIGIT: {
+            auto number = (U64)(at - '0');
             while(reader.current < reader.end) {
-                auto at = *reader.current;
-                if(!is_alpha(at) && !is_numeric(at) && at != '_') {
+                auto c = *reader.current;
+                if((char_table.entries[c] & CHAR_IN_NUMBER) == 0) {
                     break;
                 }
 
+                if(c != '_') {
+                    number = 10*number + (c - '0');
+                    if(number > (U32)-1) {
+                        stream.failed = true;
+                        return parse_error(stream, "Error: Number is too large.");
+                    }
+                }
+
                 reader.current += 1;
             }
 
-            token.type = TOKEN_ATOM;
-        }
-        else if(at == '"') {
-            // string.
+            token.type = TOKEN_NUMBER;
+            token.number = (U32)number;
+        } break;
+
+        case CHAR_QUOTE: {
             auto string = String {};
 
             reader.current -= 1;
             if(!read_quoted_string(reader, string)) {
-                printf("Error: String at %lld, %lld without closing '\"'.\n", 
-                    token.source_line, token.source_column
+                auto line = (Unsigned)0;
+                auto column = (Unsigned)0;
+                get_source_location(stream.source, token.source_offset, line, column);
+                stream.failed = true;
+                return parse_error(stream, "Error: String at %lld, %lld without closing '\"'.",
+                    line, column
                 );
-                return false;
             }
 
-            token.string = intern(string_table, string);
+            token.string = intern(*stream.string_table, string);
             token.type = TOKEN_STRING;
-        }
-        else if(is_numeric(at)) {
-            // number.
-            while(reader.current < reader.end) {
-                auto at = *reader.current;
-                if(!is_numeric(at) && at != '_') {
-                    break;
-                }
-
-                reader.current += 1;
-            }
+        } break;
 
-            token.type = TOKEN_NUMBER;
-        }
-        else {
+        // NOTE(llw): Whitespace and comments were skipped above, a lone
+        //  '/' is punctuation.
+        default: {
+            token.string = lookup_fixed_string(token_begin, reader.current);
             token.type = TOKEN_OTHER;
-        }
+        } break;
+    }
 
-        if(token.string == 0) {
-            token.string = intern(string_table, str(token_begin, reader.current));
-        }
+    if(token.string == 0) {
+        token.string = intern(*stream.string_table, str(token_begin, reader.current));
+    }
+
+    if(token.type != TOKEN_NUMBER) {
+        token.source_size = (U32)(reader.current - token_begin);
+    }
+
+    return true;
+}
 
-        token.source_size = (Unsigned)(reader.current - token_begin);
-        push(result, token);
+// NOTE(llw): Makes sure at least count tokens are buffered. Returns false if
+//  the source ends (or is invalid) before that.
+static _inline bool fill(Token_Stream &stream, Usize count) {
+    assert(count <= Token_Stream::ring_size);
 
-        if(token.type == TOKEN_NUMBER && token.source_size > 10) {
-            printf("Error: Number is too large.\n");
+    while(stream.ring_count < count) {
+        auto index = (stream.ring_begin + stream.ring_count) % Token_Stream::ring_size;
+        if(!next_token(stream, stream.ring[index])) {
             return false;
         }
-    }
 
-    // NOTE(llw): Extra tokens for lookahead.
-    for(Usize i = 0; i < 2; i += 1) {
-        auto eol = Token {};
-        eol.type = TOKEN_EOL;
-        push(result, eol);
+        stream.ring_count += 1;
+        stream.token_count += 1;
     }
 
     return true;
 }
 
+// NOTE(llw): The token offset tokens ahead. Must be buffered.
+static _inline const Token &peek(const Token_Stream &stream, Usize offset = 0) {
+    assert(offset < stream.ring_count);
+    return stream.ring[(stream.ring_begin + offset) % Token_Stream::ring_size];
+}
+
+static _inline void advance(Token_Stream &stream, Usize count = 1) {
+    assert(count <= stream.ring_count);
+    stream.ring_begin = (stream.ring_begin + count) % Token_Stream::ring_size;
+    stream.ring_count -= count;
+}
+
 
 
 //
 // RANGE parser.
 //
 
-Signed skip_eol(Reader<Token> &reader) {
-    while( reader.current < reader.end
-        && reader.current->type == TOKEN_EOL
-    ) {
-        reader.current += 1;
+// NOTE(llw): After a tokenizer error the stream just ends. The error is set
+//  already, the parser doesn't replace it.
+static void end_of_file_error(Token_Stream &stream, const char *message) {
+    if(!stream.failed) {
+        parse_error(stream, "%s", message);
+    }
+}
+
+// NOTE(llw): Skips line breaks. Returns whether there are at least lookahead
+//  tokens after them.
+bool skip_eol(Token_Stream &stream, Usize lookahead) {
+    while(fill(stream, 1) && peek(stream).type == TOKEN_EOL) {
+        advance(stream);
     }
 
-    return reader.end - reader.current;
+    return fill(stream, lookahead);
 }
 
 bool is_valid(const Expression &e) {
     return e.type != 0;
 }
 
-Expression parse_expression(Reader<Token> &reader);
+// NOTE(llw): Everything parsing one file writes to besides the expressions.
+//  Doesn't touch the context, so files can be parsed on any thread, see
+//  parse_sources.
+struct Parser {
+    Token_Stream stream;
+    Allocator *allocator;
+    Ast_Pool *pool;
+    U32 next_expression_id;
+
+    // NOTE(llw): Children of the blocks and items of the lists being parsed,
+    //  used as stacks. A block or list is copied to the pool once complete,
+    //  so its entries are contiguous even if they have blocks of their own.
+    Array<Expression> block_stack;
+    Array<Argument> list_stack;
+};
+
+static Parser make_parser(
+    Allocator &allocator,
+    Ast_Pool &pool,
+    String_Table &string_table,
+    const Array<U8> &buffer,
+    U32 next_expression_id
+) {
+    auto result = Parser {};
+    result.stream = make_token_stream(string_table, buffer);
+    result.allocator = &allocator;
+    result.pool = &pool;
+    result.next_expression_id = next_expression_id;
+    result.block_stack = create_array<Expression>(allocator);
+    result.list_stack = create_array<Argument>(allocator);
+    return result;
+}
+
+Expression parse_expression(Parser &parser);
 
 bool parse_argument(
-    Reader<Token> &reader,
+    Parser &parser,
     Argument &result,
     U32 parent_expression
 ) {
-    if(reader.current >= reader.end) {
-        printf("Unexpected end of file.\n");
+    auto &stream = parser.stream;
+
+    if(!fill(stream, 1)) {
+        end_of_file_error(stream, "Unexpected end of file.");
         return false;
     }
 
     // NOTE(llw): Consume current.
-    auto at = *reader.current;
-    reader.current += 1;
+    auto at = peek(stream);
+    advance(stream);
 
     if(at.type == TOKEN_ATOM) {
         result.type = ARG_ATOM;
@@ -217,106 +498,123 @@ bool parse_argument(
     else if(at.type == TOKEN_NUMBER) {
         result.type = ARG_NUMBER;
         result.value = at.string;
+        result.number = at.number;
         return true;
     }
     else if(at.string == context.strings.curly_open) {
         result.type = ARG_BLOCK;
-        result.block = create_array<Expression>(context.arena);
+
+        auto &stack = parser.block_stack;
+        auto first = stack.count;
 
         while(true) {
 
-            if(skip_eol(reader) < 1) {
-                printf("Unexpected end of file.\n");
+            if(!skip_eol(stream, 1)) {
+                end_of_file_error(stream, "Unexpected end of file.");
                 return false;
             }
 
-            if(reader.current->string == context.strings.curly_close) {
-                reader.current += 1;
+            if(peek(stream).string == context.strings.curly_close) {
+                advance(stream);
                 break;
             }
 
-            auto expr = parse_expression(reader);
+            auto expr = parse_expression(parser);
             if(!is_valid(expr)) {
                 return false;
             }
 
             expr.parent = parent_expression;
 
-            push(result.block, expr);
+            push(stack, expr);
         }
 
+        auto count = stack.count - first;
+        result.block = allocate_expressions(*parser.pool, count);
+        copy_values(parser.pool->expressions.values + result.block.first, stack.values + first, count);
+        stack.count = first;
+
         return true;
     }
     else if(at.string == context.strings.square_open) {
         result.type = ARG_LIST;
-        result.list = create_array<Argument>(context.arena);
+
+        auto &stack = parser.list_stack;
+        auto first = stack.count;
 
         auto was_last = false;
         while(true) {
 
-            if(skip_eol(reader) < 2) {
-                printf("Unexpected eof.\n");
+            if(!skip_eol(stream, 2)) {
+                end_of_file_error(stream, "Unexpected eof.");
                 return false;
             }
 
-            auto t0 = reader.current[0];
-            auto t1 = reader.current[1];
+            auto t0 = peek(stream, 0);
+            auto t1 = peek(stream, 1);
 
             if(t0.string == context.strings.square_close) {
-                reader.current += 1;
+                advance(stream);
                 break;
             }
 
             if(was_last) {
-                printf("Comma missing after list item.\n");
+                parse_error(stream, "Comma missing after list item.");
                 return false;
             }
 
             auto value = Argument {};
-            if(!parse_argument(reader, value, parent_expression)) {
+            if(!parse_argument(parser, value, parent_expression)) {
                 return false;
             }
 
-            push(result.list, value);
+            push(stack, value);
 
             if(t1.string == context.strings.comma) {
-                reader.current += 1;
+                advance(stream);
             }
             else {
                 was_last = true;
             }
         }
 
+        auto count = stack.count - first;
+        result.list = allocate_arguments(*parser.pool, count);
+        copy_values(parser.pool->arguments.values + result.list.first, stack.values + first, count);
+        stack.count = first;
+
         return true;
     }
     else {
-        printf("Invalid argument value.\n");
+        parse_error(stream, "Invalid argument value.");
         return false;
     }
 
 }
 
-Expression parse_expression(Reader<Token> &reader) {
-    if(skip_eol(reader) < 1) {
-        printf("Unexpected end of file.\n");
+Expression parse_expression(Parser &parser) {
+    auto &stream = parser.stream;
+
+    if(!skip_eol(stream, 1)) {
+        end_of_file_error(stream, "Unexpected end of file.");
         return {};
     }
 
-    auto t0 = *reader.current;
+    auto t0 = peek(stream);
 
     // NOTE(llw): String as short hand for: text value: "..."
     if(t0.type == TOKEN_STRING) {
-        reader.current += 1;
+        advance(stream);
 
         auto value = Argument {};
         value.type = ARG_STRING;
         value.value = t0.string;
 
-        auto args = create_map<Interned_String, Argument>(context.arena, 1);
+        auto args = create_argument_map(*parser.allocator);
         insert(args, context.strings.value, value);
 
-        context.next_expression_id += 1;
-        auto own_id = context.next_expression_id;
+        parser.next_expression_id += 1;
+        auto own_id = parser.next_expression_id;
 
         auto result = Expression {};
         result.id = own_id;
@@ -331,17 +629,17 @@ Expression parse_expression(Reader<Token> &reader) {
     // NOTE(llw): Check if is multi line expression - starts with '('.
     if(t0.string == context.strings.paren_open) {
         // NOTE(llw): Consume '('.
-        reader.current += 1;
+        advance(stream);
         is_multi_line = true;
 
-        if(reader.current >= reader.end) {
-            printf("Unexpected end of file after '('\n");
+        if(!fill(stream, 1)) {
+            end_of_file_error(stream, "Unexpected end of file after '('");
             return {};
         }
 
-        auto t1 = *reader.current;
+        auto t1 = peek(stream);
         if(t1.type != TOKEN_ATOM) {
-            printf("Non-atom token after '('\n");
+            parse_error(stream, "Non-atom token after '('");
             return {};
         }
 
@@ -349,25 +647,25 @@ Expression parse_expression(Reader<Token> &reader) {
     }
 
     // NOTE(llw): Consume type.
-    reader.current += 1;
+    advance(stream);
 
 
     auto reached_eof = false;
     auto was_last = false;
 
-    context.next_expression_id += 1;
-    auto own_id = context.next_expression_id;
+    parser.next_expression_id += 1;
+    auto own_id = parser.next_expression_id;
 
     // NOTE(llw): Parse arguments.
-    auto arguments = create_map<Interned_String, Argument>(context.arena);
-    while(reader.current < reader.end) {
+    auto arguments = create_argument_map(*parser.allocator);
+    while(fill(stream, 1)) {
 
-        if(is_multi_line && skip_eol(reader) < 1) {
+        if(is_multi_line && !skip_eol(stream, 1)) {
             reached_eof = true;
             break;
         }
 
-        auto at = *reader.current;
+        auto at = peek(stream);
 
         auto done = was_last;
         if(is_multi_line) {
@@ -381,7 +679,7 @@ Expression parse_expression(Reader<Token> &reader) {
         if(done) {
             // NOTE(llw): Consume ')'.
             if(is_multi_line) {
-                reader.current += 1;
+                advance(stream);
             }
 
             auto result = Expression {};
@@ -392,47 +690,47 @@ Expression parse_expression(Reader<Token> &reader) {
         }
 
         // NOTE(llw): Parse "name : value".
-        if(reader.current + 3 > reader.end) {
-            printf("Not enough tokens.\n");
+        if(!fill(stream, 3)) {
+            end_of_file_error(stream, "Not enough tokens.");
             return {};
         }
 
-        auto t0 = reader.current[0];
-        auto t1 = reader.current[1];
-        auto t2 = reader.current[2];
+        auto t0 = peek(stream, 0);
+        auto t1 = peek(stream, 1);
+        auto t2 = peek(stream, 2);
 
         if(t0.type != TOKEN_ATOM) {
-            printf("Argument must begin with name.\n");
+            parse_error(stream, "Argument must begin with name.");
             return {};
         }
 
         if(t1.string != context.strings.colon) {
-            printf("Argument name must be followed by a colon.\n");
+            parse_error(stream, "Argument name must be followed by a colon.");
             return {};
         }
 
         // NOTE(llw): Consume name and colon.
-        reader.current += 2;
+        advance(stream, 2);
 
         auto arg_name = t0.string;
         auto arg = Argument {};
-        if(!parse_argument(reader, arg, own_id)) {
+        if(!parse_argument(parser, arg, own_id)) {
             return {};
         }
 
         if(has(arguments, arg_name)) {
-            printf("Argument provided multiple times.\n");
+            parse_error(stream, "Argument provided multiple times.");
             return {};
         }
         insert(arguments, arg_name, arg);
 
         // NOTE(llw): Try to consume ',' or '\n'.
-        if(reader.current < reader.end) {
-            if(reader.current->string == context.strings.comma) {
-                reader.current += 1;
+        if(fill(stream, 1)) {
+            if(peek(stream).string == context.strings.comma) {
+                advance(stream);
             }
-            else if(is_multi_line && reader.current->type == TOKEN_EOL) {
-                reader.current += 1;
+            else if(is_multi_line && peek(stream).type == TOKEN_EOL) {
+                advance(stream);
             }
             else {
                 was_last = true;
@@ -444,9 +742,14 @@ Expression parse_expression(Reader<Token> &reader) {
 
     }
 
-    printf("Error: Reached end of file in expression starting at %lld, %lld.\n",
-        t0.source_line, t0.source_column
-    );
+    if(!stream.failed) {
+        auto line = (Unsigned)0;
+        auto column = (Unsigned)0;
+        get_source_location(stream.source, t0.source_offset, line, column);
+        parse_error(stream, "Error: Reached end of file in expression starting at %lld, %lld.",
+            line, column
+        );
+    }
     return {};
 }
 
@@ -481,24 +784,26 @@ void print(const Expression &expr, Unsigned indent) {
     for(Usize i = 0; i < arguments.count; i += 1) {
         do_indent(1);
 
-        auto arg_name = arguments.entries[i].key;
-        auto arg      = arguments.entries[i].value;
+        auto arg_name = get_key(arguments, i);
+        auto arg      = get_value(arguments, i);
 
         printf("name: %s, ", string_table[arg_name].values);
 
         if(arg.type == ARG_BLOCK) {
             printf("type: block\n");
 
-            for(Usize i = 0; i < arg.block.count; i += 1) {
-                print(arg.block[i], indent + 2);
+            auto block = get_block(arg);
+            for(Usize i = 0; i < block.count; i += 1) {
+                print(block[i], indent + 2);
             }
         }
         else if(arg.type == ARG_LIST) {
             printf("type: list\n");
 
-            for(Usize i = 0; i < arg.list.count; i += 1) {
+            auto list = get_list(arg);
+            for(Usize i = 0; i < list.count; i += 1) {
                 do_indent(2);
-                print_simple_arg(arg.list[i].type, arg.list[i].value);
+                print_simple_arg(list[i].type, list[i].value);
             }
         }
         else {
@@ -507,81 +812,453 @@ void print(const Expression &expr, Unsigned indent) {
     }
 }
 
-bool parse(const Array<U8> &buffer) {
-    auto tokens = create_array<Token>(context.temporary);
-    if(!tokenize(context.string_table, buffer, tokens)) {
-        return false;
+static bool parse_file(Parser &parser, Array<Expression> &expressions) {
+    auto &stream = parser.stream;
+
+    // NOTE(llw): Tokens store 32 bit offsets.
+    if(stream.reader.end - stream.reader.current > (Ssize)(U32)-1) {
+        return parse_error(stream, "Error: Source file is larger than 4 GiB.");
     }
 
-    auto token_reader = Reader<Token> {
-        tokens.values,
-        tokens.values + tokens.count
-    };
     while(true) {
 
-        if(skip_eol(token_reader) < 1) {
+        if(!skip_eol(stream, 1)) {
             break;
         }
 
-        auto expr = parse_expression(token_reader);
+        auto expr = parse_expression(parser);
         if(!is_valid(expr)) {
             return false;
         }
 
-        push(context.expressions, expr);
+        push(expressions, expr);
     }
 
-    return true;
+    // NOTE(llw): Tokenizer errors look like the end of the file to the
+    //  parser.
+    return !stream.failed;
 }
 
 
-Argument create_argument(Argument_Type type, Allocator &allocator) {
-    auto result = Argument {};
-    result.type = type;
+//
+// RANGE parallel parsing.
+//
 
-    switch(result.type) {
-        case ARG_ATOM:
-        case ARG_STRING:
-        case ARG_NUMBER: {} break;
+// NOTE(llw): One file parsed on a worker. Ids of strings and expressions are
+//  local to the file until merge_parse_job maps them into the context.
+struct Parse_Job {
+    Source *source;
+
+    String_Table string_table;
+    Ast_Pool pool;
+    Array<Expression> expressions;
+    U32 expression_count;
+    Usize token_count;
+    // NOTE(llw): If not ok, printed when the job would be merged.
+    const char *error;
+
+    U32 thread_index;
+    U64 begin_ns;
+    U64 duration_ns;
+    bool ok;
+    bool from_cache;
+};
 
-        case ARG_BLOCK: {
-            result.block = { &allocator };
-        } break;
+struct Parse_Jobs {
+    Parse_Job *values;
+    U32 count;
+    volatile U32 next;
+    // NOTE(llw): NULL without -cache.
+    const char *cache_directory;
+};
 
-        case ARG_LIST: {
-            result.list = { &allocator };
-        } break;
+struct Parse_Worker {
+    Thread thread;
+    U32 index;
+    Arena *arena;
+    Parse_Jobs *jobs;
+    bool started;
+};
+
+static void reset_parse_job(Parse_Job &job, Arena &arena) {
+    // NOTE(llw): Same fixed ids as the context, so the tokenizer's
+    //  lookup_fixed_string and context.strings hold for the local table.
+    job.string_table = create_string_table(arena);
+    intern_fixed_strings(job.string_table);
+
+    job.pool = create_ast_pool(arena, arena);
+    job.expressions = create_array<Expression>(arena);
+    job.expression_count = 0;
+}
+
+static void run_parse_job(Parse_Job &job, Arena &arena, const char *cache_directory, U32 thread_index) {
+    job.thread_index = thread_index;
+    job.begin_ns = get_time_ns();
+    defer {
+        release_source(*job.source);
+        job.duration_ns = get_time_ns() - job.begin_ns;
+    };
+
+    auto &content = job.source->content;
+
+    reset_parse_job(job, arena);
+
+    if(cache_directory != NULL) {
+        job.from_cache = load_ast_cache_entry(
+            cache_directory, content,
+            job.string_table, job.pool, job.expressions, job.expression_count,
+            arena
+        );
+        if(job.from_cache) {
+            job.ok = true;
+            return;
+        }
+
+        // NOTE(llw): An invalid entry may have filled in some of it.
+        reset_parse_job(job, arena);
     }
 
-    return result;
+    auto parser = make_parser(arena, job.pool, job.string_table, content, 0);
+    job.ok = parse_file(parser, job.expressions);
+    job.expression_count = parser.next_expression_id;
+    job.token_count = parser.stream.token_count;
+
+    if(!job.ok) {
+        auto size = strlen(parser.stream.error);
+        auto error = allocate_array_uninitialized<char>(size + 1, arena);
+        copy_bytes(error, parser.stream.error, size + 1);
+        job.error = error;
+    }
+
+    if(job.ok && cache_directory != NULL) {
+        save_ast_cache_entry(
+            cache_directory, content,
+            job.string_table, job.pool, job.expressions, job.expression_count
+        );
+    }
 }
 
-Argument duplicate(const Argument &argument, Allocator &allocator) {
-    auto result = Argument {};
-    result.type = argument.type;
+static void parse_worker_proc(void *data) {
+    auto &worker = *(Parse_Worker *)data;
+    auto &jobs = *worker.jobs;
 
+    while(true) {
+        auto index = atomic_add(&jobs.next, 1);
+        if(index >= jobs.count) {
+            break;
+        }
+
+        run_parse_job(jobs.values[index], *worker.arena, jobs.cache_directory, worker.index);
+    }
+}
+
+// NOTE(llw): From the ids and pool indices of a job to the context's.
+struct Parse_Remap {
+    const Interned_String *ids;
+    U32 id_base;
+    U32 expression_base;
+    U32 argument_base;
+};
+
+// NOTE(llw): Not recursive, every pool entry is remapped once.
+static void remap(Argument &argument, const Parse_Remap &map) {
     switch(argument.type) {
         case ARG_ATOM:
         case ARG_STRING:
         case ARG_NUMBER: {
-            result.value = argument.value;
+            argument.value = map.ids[argument.value];
         } break;
 
         case ARG_BLOCK: {
-            result.block = duplicate(argument.block, allocator);
-            for(Usize i = 0; i < result.block.count; i += 1) {
-                result.block[i] = duplicate(result.block[i], allocator);
-            }
+            argument.block.first += map.expression_base;
         } break;
 
         case ARG_LIST: {
-            result.list = duplicate(argument.list, allocator);
-            for(Usize i = 0; i < result.list.count; i += 1) {
-                result.list[i] = duplicate(result.list[i], allocator);
-            }
+            argument.list.first += map.argument_base;
         } break;
     }
+}
+
+static void remap(Expression &expression, const Parse_Remap &map) {
+    expression.id += map.id_base;
+    if(expression.parent != 0) {
+        expression.parent += map.id_base;
+    }
+
+    expression.type = map.ids[expression.type];
+
+    // NOTE(llw): Keys are searched linearly, changing them in place is fine.
+    auto &arguments = expression.arguments;
+    auto keys = get_keys(arguments);
+    auto values = get_values(arguments);
+    for(Usize i = 0; i < arguments.count; i += 1) {
+        keys[i] = map.ids[keys[i]];
+        remap(values[i], map);
+    }
+}
+
+// NOTE(llw): Jobs are merged in file order. Interning a file's strings in
+//  local id order, which is the order of their first use in the file, hands
+//  out the same ids as parsing the files one after the other.
+static void merge_parse_job(Parse_Job &job) {
+    TEMP_SCOPE(context.temporary);
+
+    auto &table = job.string_table;
+    auto ids = allocate_array_uninitialized<Interned_String>(table.previous_id + 1, context.temporary);
+
+    for(Usize id = 0; id <= fixed_string_count; id += 1) {
+        ids[id] = (Interned_String)id;
+    }
+    for(Usize id = fixed_string_count + 1; id <= table.previous_id; id += 1) {
+        ids[id] = intern(context.string_table, table[(Interned_String)id]);
+    }
+
+    auto &pool = context.ast;
+
+    auto map = Parse_Remap {};
+    map.ids = ids;
+    map.id_base = context.next_expression_id;
+    map.expression_base = (U32)pool.expressions.count;
+    map.argument_base = (U32)pool.arguments.count;
+
+    // NOTE(llw): The job's pool is appended as a whole, so its ranges just
+    //  move by the bases.
+    auto expressions = allocate_expressions(pool, job.pool.expressions.count);
+    auto arguments = allocate_arguments(pool, job.pool.arguments.count);
+    copy_values(pool.expressions.values + expressions.first, job.pool.expressions.values, expressions.count);
+    copy_values(pool.arguments.values + arguments.first, job.pool.arguments.values, arguments.count);
+
+    for(U32 i = 0; i < expressions.count; i += 1) {
+        remap(pool.expressions[expressions.first + i], map);
+    }
+    for(U32 i = 0; i < arguments.count; i += 1) {
+        remap(pool.arguments[arguments.first + i], map);
+    }
+
+    for(Usize i = 0; i < job.expressions.count; i += 1) {
+        auto &expression = job.expressions[i];
+        remap(expression, map);
+        push(context.expressions, expression);
+    }
+    context.next_expression_id += job.expression_count;
+
+    STATS_COUNT(COUNT_TOKENS, job.token_count);
+    STATS_COUNT(COUNT_EXPRESSIONS, job.expression_count);
+    STATS_COUNT(COUNT_CACHE_HITS, job.from_cache);
+
+    push_trace_event(context.trace,
+        "parse_file", job.source->file_path,
+        job.begin_ns, job.duration_ns,
+        job.thread_index
+    );
+}
+
+static bool parse_sources_parallel(Usize thread_count) {
+    auto job_count = context.sources.count;
+
+    auto jobs = Parse_Jobs {};
+    jobs.values = allocate_array<Parse_Job>(job_count, context.arena);
+    jobs.count = (U32)job_count;
+    for(Usize i = 0; i < job_count; i += 1) {
+        jobs.values[i].source = &context.sources[i];
+    }
+
+    if(context.cache_path != 0) {
+        auto directory = (const char *)context.string_table[context.cache_path].values;
 
+        // NOTE(llw): Fails if it exists. If it really can't be created,
+        //  saving fails and everything is parsed.
+        create_directory(directory);
+        jobs.cache_directory = directory;
+    }
+
+    // NOTE(llw): The expressions stay in the worker arenas, they live as long
+    //  as the context.
+    reserve_worker_arenas(thread_count);
+
+    {
+        STATS_TIME_SCOPE(TIME_PARSE_EXPRESSION);
+
+        auto workers = allocate_array<Parse_Worker>(thread_count, context.arena);
+        for(Usize i = 0; i < thread_count; i += 1) {
+            auto &worker = workers[i];
+            worker.index = (U32)i;
+            worker.arena = context.worker_arenas[i];
+            worker.jobs = &jobs;
+        }
+
+        // NOTE(llw): The main thread is worker 0. If a thread can't be
+        //  created, the others take its share.
+        for(Usize i = 1; i < thread_count; i += 1) {
+            workers[i].started = create_thread(workers[i].thread, parse_worker_proc, &workers[i]);
+        }
+
+        parse_worker_proc(&workers[0]);
+
+        for(Usize i = 1; i < thread_count; i += 1) {
+            if(workers[i].started) {
+                join_thread(workers[i].thread);
+            }
+        }
+    }
+
+    STATS_TIME_SCOPE(TIME_PARSE_MERGE);
+
+    for(Usize i = 0; i < job_count; i += 1) {
+        auto &job = jobs.values[i];
+        if(!job.ok) {
+            printf("%s\n", job.error);
+            return false;
+        }
+
+        merge_parse_job(job);
+    }
+
+    return true;
+}
+
+static bool parse_sources_sequential() {
+    STATS_TIME_SCOPE(TIME_PARSE_EXPRESSION);
+
+    for(Usize i = 0; i < context.sources.count; i += 1) {
+        auto &source = context.sources[i];
+        TRACE_SCOPE("parse_file", source.file_path);
+
+        auto parser = make_parser(
+            context.arena, context.ast, context.string_table,
+            source.content,
+            context.next_expression_id
+        );
+        auto ok = parse_file(parser, context.expressions);
+
+        STATS_COUNT(COUNT_TOKENS, parser.stream.token_count);
+        STATS_COUNT(COUNT_EXPRESSIONS, parser.next_expression_id - context.next_expression_id);
+        context.next_expression_id = parser.next_expression_id;
+
+        if(!ok) {
+            printf("%s\n", parser.stream.error);
+            return false;
+        }
+
+        // NOTE(llw): Everything the parser keeps is interned.
+        release_source(source);
+    }
+
+    return true;
+}
+
+bool parse_sources() {
+    auto thread_count = get_worker_count(context.sources.count);
+
+    // NOTE(llw): Cache entries are jobs, so the cache always takes the
+    //  parallel path, even on one thread.
+    if(thread_count > 1 || context.cache_path != 0) {
+        return parse_sources_parallel(thread_count);
+    }
+    else {
+        return parse_sources_sequential();
+    }
+}
+
+
+//
+// RANGE ast pool.
+//
+
+Ast_Pool create_ast_pool(Allocator &expression_allocator, Allocator &argument_allocator) {
+    auto result = Ast_Pool {};
+    result.expressions = create_array<Expression>(expression_allocator);
+    result.arguments = create_array<Argument>(argument_allocator);
+    return result;
+}
+
+void destroy(Ast_Pool &pool) {
+    destroy(pool.expressions);
+    destroy(pool.arguments);
+}
+
+template <typename T>
+static Ast_Range allocate_range(Array<T> &array, Usize count, Mutex *mutex) {
+    if(mutex != NULL) {
+        lock(*mutex);
+    }
+    defer {
+        if(mutex != NULL) {
+            unlock(*mutex);
+        }
+    };
+
+    assert(array.count + count <= (U32)-1);
+
+    auto result = Ast_Range { (U32)array.count, (U32)count };
+    if(array.count + count > array.capacity) {
+        if(mutex != NULL) {
+            // NOTE(llw): Other threads read values without the lock, so it
+            //  must not be written. Only grows in place.
+            auto capacity = next_power_of_two(array.count + count);
+            auto resized = try_resize_array(array.values, array.capacity, capacity, *array.allocator);
+            always_assert(resized);
+            array.capacity = capacity;
+        }
+        else {
+            grow(array, array.count + count);
+        }
+    }
+    array.count += count;
+    return result;
+}
+
+Ast_Range allocate_expressions(Ast_Pool &pool, Usize count) {
+    return allocate_range(pool.expressions, count, pool.lock);
+}
+
+Ast_Range allocate_arguments(Ast_Pool &pool, Usize count) {
+    return allocate_range(pool.arguments, count, pool.lock);
+}
+
+Argument_Map create_argument_map(Allocator &allocator) {
+    auto result = Argument_Map {};
+    result.allocator = &allocator;
+    result.capacity = Argument_Map::inline_capacity;
+    return result;
+}
+
+void reserve(Argument_Map &map, Usize capacity) {
+    if(capacity <= map.capacity) {
+        return;
+    }
+
+    if(map.spilled_keys == NULL && capacity <= Argument_Map::inline_capacity) {
+        map.capacity = Argument_Map::inline_capacity;
+        return;
+    }
+
+    assert(map.allocator != NULL);
+    assert(capacity <= (U32)-1);
+    auto &allocator = *map.allocator;
+
+    auto keys   = allocate_array_uninitialized<Interned_String>(capacity, allocator);
+    auto values = allocate_array_uninitialized<Argument>(capacity, allocator);
+    copy_values(keys,   get_keys(map),   map.count);
+    copy_values(values, get_values(map), map.count);
+
+    if(map.spilled_keys != NULL) {
+        free(map.spilled_keys, allocator);
+        free(map.spilled_values, allocator);
+    }
+
+    map.spilled_keys = keys;
+    map.spilled_values = values;
+    map.capacity = (U32)capacity;
+}
+
+// NOTE(llw): Shallow, the values still share their blocks and lists.
+Argument_Map duplicate(const Argument_Map &map, Allocator &allocator) {
+    auto result = create_argument_map(allocator);
+    reserve(result, map.count);
+    copy_values(get_keys(result),   get_keys(map),   map.count);
+    copy_values(get_values(result), get_values(map), map.count);
+    result.count = map.count;
     return result;
 }
 
@@ -589,12 +1266,6 @@ Expression duplicate(const Expression &expression, Allocator &allocator) {
     auto result = Expression {};
     result = expression;
     result.arguments = duplicate(expression.arguments, allocator);
-
-    for(Usize i = 0; i < result.arguments.count; i += 1) {
-        auto &v = result.arguments.entries[i].value;
-        v = duplicate(v, allocator);
-    }
-
     return result;
 }
 
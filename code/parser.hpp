@@ -3,6 +3,7 @@
 #include "util.hpp"
 
 #include <libcpp/memory/arena.hpp>
+#include <libcpp/util/thread.hpp>
 
 struct Expression;
 
@@ -17,18 +18,28 @@ enum Argument_Type {
 
 extern const char *argument_type_strings[ARG_LIST + 1];
 
+// NOTE(llw): Contiguous entries of an Ast_Pool array.
+struct Ast_Range {
+    U32 first;
+    U32 count;
+};
+
 struct Argument {
     union {
-        Interned_String   value;
-        Array<Expression> block;
-        Array<Argument>   list;
+        struct {
+            Interned_String value;
+            // NOTE(llw): ARG_NUMBER only, parsed by the tokenizer. value is
+            //  still the spelling.
+            U32 number;
+        };
+        // NOTE(llw): Into Ast_Pool::expressions.
+        Ast_Range block;
+        // NOTE(llw): Into Ast_Pool::arguments.
+        Ast_Range list;
     };
     Argument_Type type;
 };
 
-Argument duplicate(const Argument &argument, Allocator &allocator);
-Argument create_argument(Argument_Type type, Allocator &allocator);
-
 _inline bool is_arg_type(const Argument *arg, Argument_Type t) {
     return arg != NULL && arg->type == t;
 }
@@ -39,49 +50,218 @@ _inline bool is_block (const Argument *arg) { return is_arg_type(arg, ARG_BLOCK)
 _inline bool is_list  (const Argument *arg) { return is_arg_type(arg, ARG_LIST); }
 
 
+
+// NOTE(llw): The arguments of an expression, in insertion order. Almost all
+//  expressions have a handful, so those live inline and are found with a
+//  linear search. More spill to arrays from allocator. Like Map, removing
+//  moves the last entry into the hole, and copies of a spilled map share
+//  its arrays.
+struct Argument_Map {
+    static constexpr U32 inline_capacity = 4;
+
+    Allocator *allocator;
+    U32 count;
+    U32 capacity;
+
+    // NOTE(llw): NULL while inline.
+    Interned_String *spilled_keys;
+    Argument *spilled_values;
+
+    Interned_String inline_keys[inline_capacity];
+    Argument inline_values[inline_capacity];
+
+    _inline Argument &operator[](Interned_String key);
+    _inline const Argument &operator[](Interned_String key) const;
+};
+
+Argument_Map create_argument_map(Allocator &allocator);
+Argument_Map duplicate(const Argument_Map &map, Allocator &allocator);
+
+// NOTE(llw): Only allocates beyond inline_capacity.
+void reserve(Argument_Map &map, Usize capacity);
+
+_inline Interned_String *get_keys(Argument_Map &map) {
+    return map.spilled_keys != NULL ? map.spilled_keys : map.inline_keys;
+}
+_inline const Interned_String *get_keys(const Argument_Map &map) {
+    return map.spilled_keys != NULL ? map.spilled_keys : map.inline_keys;
+}
+_inline Argument *get_values(Argument_Map &map) {
+    return map.spilled_values != NULL ? map.spilled_values : map.inline_values;
+}
+_inline const Argument *get_values(const Argument_Map &map) {
+    return map.spilled_values != NULL ? map.spilled_values : map.inline_values;
+}
+
+_inline Interned_String get_key(const Argument_Map &map, Usize index) {
+    assert(index < map.count);
+    return get_keys(map)[index];
+}
+_inline Argument &get_value(Argument_Map &map, Usize index) {
+    assert(index < map.count);
+    return get_values(map)[index];
+}
+_inline const Argument &get_value(const Argument_Map &map, Usize index) {
+    assert(index < map.count);
+    return get_values(map)[index];
+}
+
+// NOTE(llw): Returns map.count if key isn't in map.
+_inline Usize find(const Argument_Map &map, Interned_String key) {
+    auto keys = get_keys(map);
+    for(Usize i = 0; i < map.count; i += 1) {
+        if(keys[i] == key) {
+            return i;
+        }
+    }
+    return map.count;
+}
+
+_inline bool has(const Argument_Map &map, Interned_String key) {
+    return find(map, key) < map.count;
+}
+
+_inline Argument *get_pointer(Argument_Map &map, Interned_String key) {
+    auto index = find(map, key);
+    return index < map.count ? &get_values(map)[index] : NULL;
+}
+_inline const Argument *get_pointer(const Argument_Map &map, Interned_String key) {
+    auto index = find(map, key);
+    return index < map.count ? &get_values(map)[index] : NULL;
+}
+
+_inline Argument &Argument_Map::operator[](Interned_String key) {
+    auto result = get_pointer(*this, key);
+    assert(result != NULL);
+    return *result;
+}
+_inline const Argument &Argument_Map::operator[](Interned_String key) const {
+    auto result = get_pointer(*this, key);
+    assert(result != NULL);
+    return *result;
+}
+
+_inline bool insert_maybe(Argument_Map &map, Interned_String key, const Argument &value) {
+    if(has(map, key)) {
+        return false;
+    }
+
+    if(map.count == map.capacity) {
+        auto capacity = 2*(Usize)map.capacity;
+        reserve(map, capacity > map.inline_capacity ? capacity : map.inline_capacity);
+    }
+
+    get_keys(map)[map.count] = key;
+    get_values(map)[map.count] = value;
+    map.count += 1;
+    return true;
+}
+
+_inline void insert(Argument_Map &map, Interned_String key, const Argument &value) {
+    auto inserted = insert_maybe(map, key, value);
+    assert(inserted);
+    UNUSED(inserted);
+}
+
+_inline bool remove_maybe(Argument_Map &map, Interned_String key) {
+    auto index = find(map, key);
+    if(index == map.count) {
+        return false;
+    }
+
+    map.count -= 1;
+    get_keys(map)[index] = get_keys(map)[map.count];
+    get_values(map)[index] = get_values(map)[map.count];
+    return true;
+}
+
+_inline void remove(Argument_Map &map, Interned_String key) {
+    auto removed = remove_maybe(map, key);
+    assert(removed);
+    UNUSED(removed);
+}
+
+
 struct Expression {
     U32 id;
     U32 parent;
     Interned_String type;
-    Map<Interned_String, Argument> arguments;
+    Argument_Map arguments;
 };
 
-Expression duplicate(const Expression &expression, Allocator &allocator);
 
-bool parse(const Array<U8> &buffer);
+//
+// RANGE ast pool.
+//
 
-void print(const Expression &expression, Unsigned indent = 0);
+// NOTE(llw): The children of blocks and the items of lists live in these
+//  arrays, Arguments refer to them by Ast_Range. Top level expressions are
+//  held by the caller (eg. context.expressions). Ranges are never freed or
+//  resized, and entries don't change once filled, so ranges can be shared.
+//  Changing a block or list copies it to a new range.
+//  context.ast is the pool of the compiler. Its arrays are the only
+//  allocations in their virtual arenas, so they grow in place and pointers
+//  into them stay valid. Other pools may move when they grow.
+struct Ast_Pool {
+    Array<Expression> expressions;
+    Array<Argument> arguments;
+    // NOTE(llw): If set, allocating takes it, so several threads can
+    //  allocate from the pool. Others read the pool without it, so only the
+    //  counts and capacities change then, the arrays grow in place. Readers
+    //  go through get_expressions and get_arguments, which don't look at
+    //  the counts. A thread may only read the ranges of another after
+    //  synchronizing with it.
+    Mutex *lock;
+};
 
-namespace libcpp {
-    template <>
-    _inline bool eq(Argument left, Argument right) {
-        if(left.type != right.type) {
-            return false;
-        }
+Ast_Pool create_ast_pool(Allocator &expression_allocator, Allocator &argument_allocator);
+void destroy(Ast_Pool &pool);
 
-        switch(left.type) {
+// NOTE(llw): The new entries are uninitialized.
+Ast_Range allocate_expressions(Ast_Pool &pool, Usize count);
+Ast_Range allocate_arguments(Ast_Pool &pool, Usize count);
 
-            case ARG_ATOM:
-            case ARG_STRING:
-            case ARG_NUMBER: {
-                return left.value == right.value;
-            } break;
+template <typename T>
+struct Ast_Slice {
+    T *values;
+    Usize count;
 
-            case ARG_BLOCK: {
-                assert(false);
-                return false;
-                //return eq(left.block, right.block);
-            } break;
+    _inline T &operator[](Usize index) const {
+        assert(index < count);
+        return values[index];
+    }
+};
 
-            case ARG_LIST: {
-                return eq(left.list, right.list);
-            } break;
+// NOTE(llw): The counts are only checked while the pool isn't shared, see
+//  Ast_Pool::lock.
+_inline Ast_Slice<Expression> get_expressions(const Ast_Pool &pool, Ast_Range range) {
+    assert(pool.lock != NULL || range.first + range.count <= pool.expressions.count);
+    return { pool.expressions.values + range.first, range.count };
+}
 
-            default: {
-                assert(false);
-                return false;
-            } break;
-        }
-    }
+_inline Ast_Slice<Argument> get_arguments(const Ast_Pool &pool, Ast_Range range) {
+    assert(pool.lock != NULL || range.first + range.count <= pool.arguments.count);
+    return { pool.arguments.values + range.first, range.count };
+}
+
+_inline Ast_Slice<Expression> get_block(const Ast_Pool &pool, const Argument &argument) {
+    assert(argument.type == ARG_BLOCK);
+    return get_expressions(pool, argument.block);
+}
+
+_inline Ast_Slice<Argument> get_list(const Ast_Pool &pool, const Argument &argument) {
+    assert(argument.type == ARG_LIST);
+    return get_arguments(pool, argument.list);
 }
 
+// NOTE(llw): Copies the argument map into allocator. Blocks and lists are
+//  shared with expression, ranges don't change after they are filled.
+Expression duplicate(const Expression &expression, Allocator &allocator);
+
+
+// NOTE(llw): Parses context.sources into context.expressions, on
+//  context.thread_count threads. The result doesn't depend on the thread
+//  count.
+bool parse_sources();
+
+void print(const Expression &expression, Unsigned indent = 0);
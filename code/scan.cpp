@@ -0,0 +1,302 @@
+#include "scan.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define SCAN_X64
+    #include <immintrin.h>
+    #if defined(LIBCPP_MSVC)
+        #include <intrin.h>
+    #endif
+#endif
+
+// NOTE(llw): msvc allows avx2 intrinsics anywhere, clang only in functions
+//  compiled for avx2.
+#if defined(LIBCPP_MSVC)
+    #define SCAN_AVX2
+#else
+    #define SCAN_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+//
+// RANGE bits.
+//
+
+static _inline U32 count_trailing_zeros(U32 value) {
+#if defined(LIBCPP_MSVC)
+    unsigned long result;
+    _BitScanForward(&result, value);
+    return (U32)result;
+#else
+    return (U32)__builtin_ctz(value);
+#endif
+}
+
+static _inline U32 highest_bit(U32 value) {
+#if defined(LIBCPP_MSVC)
+    unsigned long result;
+    _BitScanReverse(&result, value);
+    return (U32)result;
+#else
+    return 31 - (U32)__builtin_clz(value);
+#endif
+}
+
+// NOTE(llw): No popcnt instruction, it isn't part of sse2.
+static _inline U32 count_bits(U32 value) {
+    value = value - ((value >> 1) & 0x55555555u);
+    value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+    value = (value + (value >> 4)) & 0x0f0f0f0fu;
+    return (value * 0x01010101u) >> 24;
+}
+
+// NOTE(llw): Applies the masks of one block of width bytes. Returns the index
+//  of the first non whitespace byte, or width if there is none.
+static _inline Usize apply_whitespace_masks(
+    const U8 *block, Usize width,
+    U32 whitespace, U32 newlines,
+    Unsigned &line, const U8 *&line_begin
+) {
+    auto all = width == 32 ? (U32)-1 : ((U32)1 << width) - 1;
+
+    auto stop = width;
+    if(whitespace != all) {
+        stop = count_trailing_zeros(~whitespace);
+        newlines &= ((U32)1 << stop) - 1;
+    }
+
+    if(newlines != 0) {
+        line += count_bits(newlines);
+        line_begin = block + highest_bit(newlines) + 1;
+    }
+
+    return stop;
+}
+
+
+//
+// RANGE scalar.
+//
+
+static const U8 *skip_whitespace_scalar(
+    const U8 *begin, const U8 *end,
+    Unsigned &line, const U8 *&line_begin
+) {
+    auto current = begin;
+    while(current < end) {
+        auto at = *current;
+        if(    at != ' '
+            && at != '\t'
+            && at != '\r'
+            && at != '\n'
+        ) {
+            break;
+        }
+
+        if(at == '\n') {
+            line += 1;
+            line_begin = current + 1;
+        }
+
+        current += 1;
+    }
+    return current;
+}
+
+static const U8 *find_either_scalar(const U8 *begin, const U8 *end, U8 a, U8 b) {
+    auto current = begin;
+    while(current < end && *current != a && *current != b) {
+        current += 1;
+    }
+    return current;
+}
+
+
+#if defined(SCAN_X64)
+
+//
+// RANGE sse2.
+//
+
+static const U8 *skip_whitespace_sse2(
+    const U8 *begin, const U8 *end,
+    Unsigned &line, const U8 *&line_begin
+) {
+    auto space    = _mm_set1_epi8(' ');
+    auto tab      = _mm_set1_epi8('\t');
+    auto carriage = _mm_set1_epi8('\r');
+    auto newline  = _mm_set1_epi8('\n');
+
+    auto current = begin;
+
+    // NOTE(llw): Most runs are short (indentation), don't bother with a
+    //  block unless the first byte is whitespace.
+    while(end - current >= 16) {
+        auto at = *current;
+        if(at != ' ' && at != '\t' && at != '\r' && at != '\n') {
+            return current;
+        }
+
+        auto block = _mm_loadu_si128((const __m128i *)current);
+        auto is_newline = _mm_cmpeq_epi8(block, newline);
+        auto is_whitespace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, carriage), is_newline)
+        );
+
+        auto stop = apply_whitespace_masks(
+            current, 16,
+            (U32)_mm_movemask_epi8(is_whitespace),
+            (U32)_mm_movemask_epi8(is_newline),
+            line, line_begin
+        );
+
+        current += stop;
+        if(stop < 16) {
+            return current;
+        }
+    }
+
+    return skip_whitespace_scalar(current, end, line, line_begin);
+}
+
+static const U8 *find_either_sse2(const U8 *begin, const U8 *end, U8 a, U8 b) {
+    auto va = _mm_set1_epi8((char)a);
+    auto vb = _mm_set1_epi8((char)b);
+
+    auto current = begin;
+    while(end - current >= 16) {
+        auto block = _mm_loadu_si128((const __m128i *)current);
+        auto mask = (U32)_mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(block, va),
+            _mm_cmpeq_epi8(block, vb)
+        ));
+
+        if(mask != 0) {
+            return current + count_trailing_zeros(mask);
+        }
+        current += 16;
+    }
+
+    return find_either_scalar(current, end, a, b);
+}
+
+
+//
+// RANGE avx2.
+//
+
+SCAN_AVX2
+static const U8 *skip_whitespace_avx2(
+    const U8 *begin, const U8 *end,
+    Unsigned &line, const U8 *&line_begin
+) {
+    auto space    = _mm256_set1_epi8(' ');
+    auto tab      = _mm256_set1_epi8('\t');
+    auto carriage = _mm256_set1_epi8('\r');
+    auto newline  = _mm256_set1_epi8('\n');
+
+    auto current = begin;
+    while(end - current >= 32) {
+        auto at = *current;
+        if(at != ' ' && at != '\t' && at != '\r' && at != '\n') {
+            return current;
+        }
+
+        auto block = _mm256_loadu_si256((const __m256i *)current);
+        auto is_newline = _mm256_cmpeq_epi8(block, newline);
+        auto is_whitespace = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, carriage), is_newline)
+        );
+
+        auto stop = apply_whitespace_masks(
+            current, 32,
+            (U32)_mm256_movemask_epi8(is_whitespace),
+            (U32)_mm256_movemask_epi8(is_newline),
+            line, line_begin
+        );
+
+        current += stop;
+        if(stop < 32) {
+            return current;
+        }
+    }
+
+    return skip_whitespace_sse2(current, end, line, line_begin);
+}
+
+SCAN_AVX2
+static const U8 *find_either_avx2(const U8 *begin, const U8 *end, U8 a, U8 b) {
+    auto va = _mm256_set1_epi8((char)a);
+    auto vb = _mm256_set1_epi8((char)b);
+
+    auto current = begin;
+    while(end - current >= 32) {
+        auto block = _mm256_loadu_si256((const __m256i *)current);
+        auto mask = (U32)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_cmpeq_epi8(block, va),
+            _mm256_cmpeq_epi8(block, vb)
+        ));
+
+        if(mask != 0) {
+            return current + count_trailing_zeros(mask);
+        }
+        current += 32;
+    }
+
+    return find_either_sse2(current, end, a, b);
+}
+
+static bool cpu_has_avx2() {
+#if defined(LIBCPP_MSVC)
+    int info[4];
+    __cpuid(info, 1);
+    auto has_osxsave = (info[2] & (1 << 27)) != 0;
+    auto has_avx     = (info[2] & (1 << 28)) != 0;
+    if(!has_osxsave || !has_avx) {
+        return false;
+    }
+
+    // NOTE(llw): The os has to save the ymm registers.
+    if((_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // SCAN_X64
+
+
+//
+// RANGE selection.
+//
+
+Scan_Procs scan_procs = {
+    "scalar",
+    skip_whitespace_scalar,
+    find_either_scalar,
+};
+
+void select_scan_procs(bool allow_simd) {
+    scan_procs = { "scalar", skip_whitespace_scalar, find_either_scalar };
+
+#if defined(SCAN_X64)
+    if(!allow_simd) {
+        return;
+    }
+
+    // NOTE(llw): sse2 is part of x64.
+    scan_procs = { "sse2", skip_whitespace_sse2, find_either_sse2 };
+
+    if(cpu_has_avx2()) {
+        scan_procs = { "avx2", skip_whitespace_avx2, find_either_avx2 };
+    }
+#else
+    UNUSED(allow_simd);
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <libcpp/base.hpp>
+
+using namespace libcpp;
+
+// NOTE(llw): Byte scanning kernels for the tokenizer. select_scan_procs
+//  picks the widest implementation the cpu supports (avx2, sse2, scalar).
+//  None of them read outside [begin, end).
+
+// NOTE(llw): Skips ' ', '\t', '\r' and '\n'. For every '\n', adds one to line
+//  and sets line_begin to the byte after it. Returns the first other byte or
+//  end.
+typedef const U8 *(Proc_skip_whitespace)(
+    const U8 *begin, const U8 *end,
+    Unsigned &line, const U8 *&line_begin
+);
+
+// NOTE(llw): Returns the first byte equal to a or b, or end.
+typedef const U8 *(Proc_find_either)(
+    const U8 *begin, const U8 *end,
+    U8 a, U8 b
+);
+
+struct Scan_Procs {
+    const char *name;
+    Proc_skip_whitespace *skip_whitespace;
+    Proc_find_either *find_either;
+};
+
+extern Scan_Procs scan_procs;
+
+void select_scan_procs(bool allow_simd = true);
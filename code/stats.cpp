@@ -0,0 +1,237 @@
+#include "stats.hpp"
+#include "context.hpp"
+
+#pragma warning(disable:4996) // crt secure
+#include "cstdio"
+
+
+static const char *time_names[TIME_COUNT] = {
+    "read_sources",
+    "parse",
+    "parse_expression",
+    "parse_merge",
+    "analyze",
+    "validate",
+    "instantiate",
+    "codegen",
+    "deploy",
+};
+
+// NOTE(llw): Sub-phases are indented in the text report.
+static const bool time_is_sub_phase[TIME_COUNT] = {
+    false,
+    false, true, true,
+    false, true, true,
+    false,
+    false,
+};
+
+static const char *count_names[COUNT_COUNT] = {
+    "source_bytes",
+    "tokens",
+    "expressions",
+    "cache_hits",
+    "duplicates",
+    "instance_hits",
+    "interned_strings",
+    "hash_grows",
+    "output_files",
+    "output_bytes",
+};
+
+static const char *memory_names[MEMORY_COUNT] = {
+    "setup",
+    "read_sources",
+    "parse",
+    "analyze",
+    "codegen",
+    "deploy",
+};
+
+static_assert(MEMORY_COUNT <= LIBCPP_TRACKING_MAX_TAGS, "");
+
+
+void track_arena(Stats &stats, Arena &arena) {
+    auto tracker = allocate<Tracking_Allocator>();
+    *tracker = create_tracking_allocator();
+    tracker->tag = stats.memory_tag;
+    if(!install(*tracker, arena)) {
+        destroy(*tracker);
+        free(tracker);
+        stats.untracked_arenas += 1;
+        return;
+    }
+    push(stats.memory_trackers, tracker);
+}
+
+void destroy_memory_trackers(Stats &stats) {
+    for(Usize i = 0; i < stats.memory_trackers.count; i += 1) {
+        auto tracker = stats.memory_trackers[i];
+        destroy(*tracker);
+        free(tracker);
+    }
+    destroy(stats.memory_trackers);
+}
+
+Usize set_memory_tag(Stats &stats, Usize tag) {
+    auto result = stats.memory_tag;
+    stats.memory_tag = tag;
+    for(Usize i = 0; i < stats.memory_trackers.count; i += 1) {
+        set_tag(*stats.memory_trackers[i], tag);
+    }
+    return result;
+}
+
+void finish_stats(Stats &stats) {
+    stats.counts[COUNT_INTERNED_STRINGS] = context.string_table.previous_id;
+    stats.counts[COUNT_HASH_GROWS]       = hash_grow_count - stats.hash_grow_base;
+}
+
+static F64 to_ms(U64 ns) {
+    return (F64)ns / 1e6;
+}
+
+void print_stats(const Stats &stats) {
+    printf("Stats:\n");
+
+    auto total = (U64)0;
+    for(Usize i = 0; i < TIME_COUNT; i += 1) {
+        if(!time_is_sub_phase[i]) {
+            total += stats.times[i];
+        }
+
+        printf("    %s%-*s %10.3f ms\n",
+            time_is_sub_phase[i] ? "  " : "",
+            time_is_sub_phase[i] ? 18 : 20,
+            time_names[i],
+            to_ms(stats.times[i])
+        );
+    }
+    printf("    %-20s %10.3f ms\n", "total", to_ms(total));
+
+    for(Usize i = 0; i < COUNT_COUNT; i += 1) {
+        printf("    %-20s %10llu\n", count_names[i], (unsigned long long)stats.counts[i]);
+    }
+}
+
+static F64 to_kib(Usize bytes) {
+    return (F64)bytes / 1024.0;
+}
+
+static void print_memory_row(const char *name, const Tracking_Statistics &statistics) {
+    printf("    %-14s %10llu %12.1f %10.1f %12.1f %12.1f\n",
+        name,
+        (unsigned long long)statistics.allocation_count,
+        to_kib(statistics.bytes_requested),
+        to_kib(statistics.alignment_waste),
+        to_kib(statistics.bytes_freed),
+        to_kib(statistics.peak_live_bytes)
+    );
+}
+
+static void add_statistics(Tracking_Statistics &to, const Tracking_Statistics &from) {
+    to.allocation_count += from.allocation_count;
+    to.free_count       += from.free_count;
+    to.resize_count     += from.resize_count;
+    to.bytes_requested  += from.bytes_requested;
+    to.bytes_freed      += from.bytes_freed;
+    to.alignment_waste  += from.alignment_waste;
+    to.live_bytes       += from.live_bytes;
+    to.peak_live_bytes  += from.peak_live_bytes;
+
+    for(Usize i = 0; i < LIBCPP_TRACKING_HISTOGRAM_BUCKETS; i += 1) {
+        to.histogram[i] += from.histogram[i];
+    }
+}
+
+void print_memory_stats(const Stats &stats) {
+    // NOTE(llw): Summed over the tracked arenas. They peak at different
+    //  times, so the peaks are an upper bound.
+    auto total = Tracking_Statistics {};
+    Tracking_Statistics tags[MEMORY_COUNT] = {};
+    auto footprint = (Usize)0;
+    for(Usize i = 0; i < stats.memory_trackers.count; i += 1) {
+        const auto &tracker = *stats.memory_trackers[i];
+
+        add_statistics(total, tracker.total);
+        for(Usize j = 0; j < MEMORY_COUNT; j += 1) {
+            add_statistics(tags[j], tracker.tags[j]);
+        }
+
+        footprint += get_total_used(*(const Arena *)tracker.target);
+    }
+
+    printf("Memory (%llu arenas, KiB):\n", (unsigned long long)stats.memory_trackers.count);
+    printf("    %-14s %10s %12s %10s %12s %12s\n",
+        "tag", "allocs", "requested", "align", "dead", "peak live"
+    );
+    for(Usize i = 0; i < MEMORY_COUNT; i += 1) {
+        print_memory_row(memory_names[i], tags[i]);
+    }
+    print_memory_row("total", total);
+
+    // NOTE(llw): arena_free is a no-op, so everything freed (mostly old
+    //  Array/Map buffers after growing) stays in the arena.
+    printf("    footprint %.1f KiB, live %.1f KiB, dead %.1f KiB (%.1f%%)\n",
+        to_kib(footprint),
+        to_kib(total.live_bytes),
+        to_kib(total.bytes_freed),
+        footprint > 0 ? 100.0 * (F64)total.bytes_freed / (F64)footprint : 0.0
+    );
+    if(stats.untracked_arenas > 0) {
+        printf("    %llu arenas not tracked\n", (unsigned long long)stats.untracked_arenas);
+    }
+
+    printf("    sizes:\n");
+    for(Usize i = 0; i < LIBCPP_TRACKING_HISTOGRAM_BUCKETS; i += 1) {
+        auto count = total.histogram[i];
+        if(count == 0) {
+            continue;
+        }
+
+        if(i + 1 < LIBCPP_TRACKING_HISTOGRAM_BUCKETS) {
+            printf("      <= %-10llu %10llu\n",
+                (unsigned long long)get_histogram_bucket_limit(i),
+                (unsigned long long)count
+            );
+        }
+        else {
+            printf("       > %-10llu %10llu\n",
+                (unsigned long long)get_histogram_bucket_limit(i - 1),
+                (unsigned long long)count
+            );
+        }
+    }
+}
+
+bool write_stats_json(const Stats &stats, const char *path) {
+    TEMP_SCOPE(context.temporary);
+    auto buffer = create_array<U8>(context.temporary);
+
+    char number[64];
+
+    push(buffer, STRING("{\n    \"times_ms\": {\n"));
+    for(Usize i = 0; i < TIME_COUNT; i += 1) {
+        auto size = snprintf(number, sizeof(number), "%.6f", to_ms(stats.times[i]));
+
+        push(buffer, STRING("        \""));
+        push(buffer, String { (U8 *)time_names[i], strlen(time_names[i]) });
+        push(buffer, STRING("\": "));
+        push(buffer, String { (U8 *)number, (Usize)size });
+        push(buffer, i + 1 < TIME_COUNT ? STRING(",\n") : STRING("\n"));
+    }
+
+    push(buffer, STRING("    },\n    \"counts\": {\n"));
+    for(Usize i = 0; i < COUNT_COUNT; i += 1) {
+        auto size = snprintf(number, sizeof(number), "%llu", (unsigned long long)stats.counts[i]);
+
+        push(buffer, STRING("        \""));
+        push(buffer, String { (U8 *)count_names[i], strlen(count_names[i]) });
+        push(buffer, STRING("\": "));
+        push(buffer, String { (U8 *)number, (Usize)size });
+        push(buffer, i + 1 < COUNT_COUNT ? STRING(",\n") : STRING("\n"));
+    }
+    push(buffer, STRING("    }\n}\n"));
+
+    return write_entire_file(path, buffer);
+}
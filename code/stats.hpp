@@ -0,0 +1,97 @@
+#pragma once
+
+#include "util.hpp"
+
+#include <libcpp/memory/tracking.hpp>
+#include <libcpp/util/defer.hpp>
+
+enum Stats_Time {
+    TIME_READ_SOURCES,
+    TIME_PARSE,
+    TIME_PARSE_EXPRESSION,
+    TIME_PARSE_MERGE,
+    TIME_ANALYZE,
+    TIME_VALIDATE,
+    TIME_INSTANTIATE,
+    TIME_CODEGEN,
+    TIME_DEPLOY,
+    TIME_COUNT,
+};
+
+enum Stats_Count {
+    COUNT_SOURCE_BYTES,
+    COUNT_TOKENS,
+    COUNT_EXPRESSIONS,
+    COUNT_CACHE_HITS,
+    COUNT_DUPLICATES,
+    COUNT_INSTANCE_HITS,
+    COUNT_INTERNED_STRINGS,
+    COUNT_HASH_GROWS,
+    COUNT_OUTPUT_FILES,
+    COUNT_OUTPUT_BYTES,
+    COUNT_COUNT,
+};
+
+// NOTE(llw): Tracking tags for the tracked arenas. Everything allocated
+//  before the first phase (setup, arguments) is MEMORY_SETUP.
+enum Stats_Memory {
+    MEMORY_SETUP,
+    MEMORY_READ_SOURCES,
+    MEMORY_PARSE,
+    MEMORY_ANALYZE,
+    MEMORY_CODEGEN,
+    MEMORY_DEPLOY,
+    MEMORY_COUNT,
+};
+
+struct Stats {
+    U64 times[TIME_COUNT];
+    U64 counts[COUNT_COUNT];
+
+    // NOTE(llw): libcpp::hash_grow_count is global, this is its value when
+    //  the context was set up.
+    U64 hash_grow_base;
+
+    // NOTE(llw): Only with -memory, one per tracked arena, see track_arena.
+    //  The registry points at them, so they are allocated one by one.
+    Array<Tracking_Allocator *> memory_trackers;
+    Usize memory_tag;
+    // NOTE(llw): Arenas that didn't fit, see LIBCPP_TRACKING_MAX_TARGETS.
+    Usize untracked_arenas;
+};
+
+// NOTE(llw): Adds the time until the end of the enclosing scope.
+#define STATS_TIME_SCOPE(time)                                              \
+    auto LIBCPP_CONCAT(__stats_begin_, __LINE__) = get_time_ns();           \
+    defer {                                                                 \
+        context.stats.times[time] +=                                        \
+            get_time_ns() - LIBCPP_CONCAT(__stats_begin_, __LINE__);        \
+    }
+
+// NOTE(llw): Attributes allocations from the tracked arenas until the end
+//  of the enclosing scope to the memory tag.
+#define STATS_MEMORY_SCOPE(tag)                                             \
+    auto LIBCPP_CONCAT(__stats_memory_tag_, __LINE__) =                     \
+        set_memory_tag(context.stats, (Usize)(tag));                        \
+    defer {                                                                 \
+        set_memory_tag(context.stats,                                       \
+            LIBCPP_CONCAT(__stats_memory_tag_, __LINE__));                  \
+    }
+
+#define STATS_COUNT(count, amount) context.stats.counts[count] += (U64)(amount)
+
+// NOTE(llw): Installs a tracker on the arena, for -memory. It starts out
+//  with the current memory tag. Counts the arena as untracked if the
+//  tracking registry is full.
+void track_arena(Stats &stats, Arena &arena);
+void destroy_memory_trackers(Stats &stats);
+
+// NOTE(llw): Returns the previous tag.
+Usize set_memory_tag(Stats &stats, Usize tag);
+
+// NOTE(llw): Fills in the counts that are only known at the end.
+void finish_stats(Stats &stats);
+
+void print_stats(const Stats &stats);
+void print_memory_stats(const Stats &stats);
+bool write_stats_json(const Stats &stats, const char *path);
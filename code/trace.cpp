@@ -0,0 +1,96 @@
+#include "trace.hpp"
+#include "context.hpp"
+
+#pragma warning(disable:4996) // crt secure
+#include "cstdio"
+
+
+void end_trace_span(Trace &trace, const char *name, Interned_String detail, U64 begin_ns) {
+    if(!trace.enabled) {
+        return;
+    }
+
+    push_trace_event(trace, name, detail, begin_ns, get_time_ns() - begin_ns, 0);
+}
+
+void push_trace_event(
+    Trace &trace,
+    const char *name, Interned_String detail,
+    U64 begin_ns, U64 duration_ns,
+    U32 thread_index
+) {
+    if(!trace.enabled) {
+        return;
+    }
+
+    auto event = Trace_Event {};
+    event.name         = name;
+    event.detail       = detail;
+    event.begin_ns     = begin_ns;
+    event.duration_ns  = duration_ns;
+    event.thread_index = thread_index;
+    push(trace.events, event);
+}
+
+
+static void push_json_string(Array<U8> &buffer, String string) {
+    push(buffer, (U8)'"');
+    for(Usize i = 0; i < string.size; i += 1) {
+        auto at = string.values[i];
+
+        // NOTE(llw): Interned file paths include their null terminator.
+        if(at == 0) {
+            break;
+        }
+
+        if(at == '"' || at == '\\') {
+            push(buffer, (U8)'\\');
+            push(buffer, at);
+        }
+        else if(at < ' ') {
+            push(buffer, (U8)' ');
+        }
+        else {
+            push(buffer, at);
+        }
+    }
+    push(buffer, (U8)'"');
+}
+
+bool write_trace_json(const Trace &trace, const char *path) {
+    TEMP_SCOPE(context.temporary);
+    auto buffer = create_array<U8>(context.temporary);
+    reserve(buffer, 128*trace.events.count + 64);
+
+    char number[64];
+
+    push(buffer, STRING("{\"traceEvents\":[\n"));
+    for(Usize i = 0; i < trace.events.count; i += 1) {
+        const auto &event = trace.events[i];
+        auto name = String { (U8 *)event.name, strlen(event.name) };
+
+        push(buffer, STRING("{\"name\":"));
+        if(event.detail != 0) {
+            push_json_string(buffer, context.string_table[event.detail]);
+        }
+        else {
+            push_json_string(buffer, name);
+        }
+
+        push(buffer, STRING(",\"cat\":"));
+        push_json_string(buffer, name);
+
+        auto size = snprintf(number, sizeof(number),
+            ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            event.thread_index + 1,
+            (F64)(event.begin_ns - trace.base_ns)/1e3,
+            (F64)event.duration_ns/1e3
+        );
+        push(buffer, String { (U8 *)number, (Usize)size });
+
+        push(buffer, i + 1 < trace.events.count ? STRING(",\n") : STRING("\n"));
+    }
+    push(buffer, STRING("],\"displayTimeUnit\":\"ms\"}\n"));
+
+    return write_entire_file(path, buffer);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "util.hpp"
+
+#include <libcpp/util/defer.hpp>
+
+struct Trace_Event {
+    const char *name;
+    // NOTE(llw): Optional, 0 if not set. Used as the span name if present.
+    Interned_String detail;
+    U64 begin_ns;
+    U64 duration_ns;
+    // NOTE(llw): 0 is the main thread.
+    U32 thread_index;
+};
+
+struct Trace {
+    bool enabled;
+    U64 base_ns;
+    Array<Trace_Event> events;
+};
+
+_inline U64 begin_trace_span(const Trace &trace) {
+    if(!trace.enabled) {
+        return 0;
+    }
+    return get_time_ns();
+}
+
+void end_trace_span(Trace &trace, const char *name, Interned_String detail, U64 begin_ns);
+
+// NOTE(llw): For spans measured on other threads. Only call from the main
+//  thread.
+void push_trace_event(
+    Trace &trace,
+    const char *name, Interned_String detail,
+    U64 begin_ns, U64 duration_ns,
+    U32 thread_index
+);
+
+// NOTE(llw): Records a complete event for the enclosing scope if tracing is
+//  enabled.
+#define TRACE_SCOPE(name, detail)                                           \
+    auto LIBCPP_CONCAT(__trace_begin_, __LINE__) =                          \
+        begin_trace_span(context.trace);                                    \
+    defer {                                                                 \
+        end_trace_span(context.trace, (name), (detail),                     \
+            LIBCPP_CONCAT(__trace_begin_, __LINE__));                       \
+    }
+
+// NOTE(llw): Chrome trace event format, loadable in chrome://tracing and
+//  Perfetto.
+bool write_trace_json(const Trace &trace, const char *path);
@@ -1,11 +1,32 @@
 #include "util.hpp"
 #include "context.hpp"
+#include "scan.hpp"
 
 #pragma warning(disable:4996) // crt secure
 #include "cstdio"
+#include <chrono>
 
 #include <libcpp/util/defer.hpp>
 
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(LIBCPP_MSVC)
+    #include <direct.h>
+    #include <process.h>
+
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 
 //
 // RANGE files.
@@ -45,6 +66,75 @@ bool write_entire_file(const char *path, const Array<U8> &buffer) {
     return true;
 }
 
+bool map_entire_file(const char *path, Array<U8> &buffer, bool &mapped) {
+    mapped = false;
+
+#if defined(__linux__)
+    auto fd = open(path, O_RDONLY);
+    if(fd >= 0) {
+        defer { close(fd); };
+
+        struct stat info;
+        if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            auto size = (Usize)info.st_size;
+            auto values = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(values != MAP_FAILED) {
+                // NOTE(llw): The parser reads front to back, once. Advice
+                //  values aren't flags, so one call each.
+                madvise(values, size, MADV_SEQUENTIAL);
+                madvise(values, size, MADV_WILLNEED);
+
+                buffer = {};
+                buffer.values   = (U8 *)values;
+                buffer.count    = size;
+                buffer.capacity = size;
+                mapped = true;
+                return true;
+            }
+        }
+    }
+#endif
+
+    // NOTE(llw): Empty files, pipes, other platforms.
+    return read_entire_file(path, buffer);
+}
+
+void unmap_file(Array<U8> &buffer) {
+    assert(buffer.allocator == NULL);
+
+#if defined(__linux__)
+    munmap(buffer.values, buffer.capacity);
+#else
+    assert(false);
+#endif
+
+    buffer = {};
+}
+
+bool create_directory(const char *path) {
+#if defined(LIBCPP_MSVC)
+    return _mkdir(path) == 0;
+#else
+    return mkdir(path, 0755) == 0;
+#endif
+}
+
+bool replace_file(const char *from, const char *to) {
+#if defined(LIBCPP_MSVC)
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+U32 get_process_id() {
+#if defined(LIBCPP_MSVC)
+    return (U32)_getpid();
+#else
+    return (U32)getpid();
+#endif
+}
+
 
 
 //
@@ -63,19 +153,23 @@ bool read_quoted_string(Reader<U8> &reader, String &result) {
     reader.current += 1;
 
     auto begin = reader.current;
-    while(reader.current < reader.end) {
-        auto at = *reader.current;
-        if(at == '\\') {
-            reader.current += 1;
+    while(true) {
+        // NOTE(llw): Long literals are the common case, skip to the next
+        //  interesting byte a block at a time.
+        reader.current = scan_procs.find_either(reader.current, reader.end, '"', '\\');
+        if(reader.current >= reader.end) {
+            break;
         }
-        else if(at == '"') {
+
+        if(*reader.current == '"') {
             auto end = reader.current;
             result = str(begin, end);
             reader.current += 1;
             return true;
         }
 
-        reader.current += 1;
+        // NOTE(llw): Escape, skip the escaped byte.
+        reader.current += 2;
     }
 
     reader.current = old_current;
@@ -90,30 +184,36 @@ bool read_quoted_string(Reader<U8> &reader, String &result) {
 String_Table create_string_table(libcpp::Allocator &allocator) {
     auto result = String_Table {};
     result.allocator = &allocator;
+    result.storage = create_arena(allocator, KIBI(64));
     result.table.allocator = &allocator;
-    result.reverse.allocator = &allocator;
+    result.strings = create_array<String>(allocator);
+    push(result.strings, String {});
     return result;
 }
 
 Interned_String intern(String_Table &table, String string) {
-    auto pointer = get_pointer(table.table, string);
+    // NOTE(llw): Keys are 32 bit sized.
+    assert(string.size <= (U32)-1);
+    auto key = String_Table_Key { string.values, (U32)string.size, (U32)hash(string) };
 
-    if(pointer == NULL) {
-        table.previous_id += 1;
-        auto id = table.previous_id;
+    auto pointer = get_pointer(table.table, key);
+    if(pointer != NULL) {
+        return *pointer;
+    }
 
-        auto s = allocate_array_uninitialized<U8>(string.size + 1, *table.allocator);
-        copy_bytes(s, string.values, string.size);
-        s[string.size] = 0;
+    table.previous_id += 1;
+    auto id = table.previous_id;
 
-        string.values = s;
+    auto s = allocate_array_uninitialized<U8>(string.size + 1, table.storage);
+    copy_bytes(s, string.values, string.size);
+    s[string.size] = 0;
 
-        insert(table.table, string, id);
-        insert(table.reverse, id, string);
-        return id;
-    }
+    key.values = s;
 
-    return *pointer;
+    insert(table.table, key, id);
+    push(table.strings, String { s, string.size });
+    assert(table.strings.count == (Usize)id + 1);
+    return id;
 }
 
 Interned_String intern(String_Table &table, const char *string) {
@@ -205,3 +305,13 @@ void push_int(Array<U8> &buffer, U64 value) {
     push(buffer, number);
 }
 
+
+//
+// RANGE time.
+//
+
+U64 get_time_ns() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    auto result = (U64)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    return result;
+}
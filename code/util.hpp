@@ -4,6 +4,9 @@
 #include <libcpp/memory/map.hpp>
 #include <libcpp/memory/string.hpp>
 #include <libcpp/memory/allocator.hpp>
+#include <libcpp/memory/arena.hpp>
+
+#include <cstring>
 
 using namespace libcpp;
 
@@ -22,6 +25,26 @@ bool write_entire_file(
     const Array<U8> &buffer
 );
 
+// NOTE(llw): Maps the file read-only where supported (linux), otherwise
+//  falls back to read_entire_file. If mapped is set, buffer points at the
+//  mapping, has no allocator and must be released with unmap_file.
+bool map_entire_file(
+    const char *path,
+    Array<U8> &buffer,
+    bool &mapped
+);
+
+void unmap_file(Array<U8> &buffer);
+
+// NOTE(llw): Returns false if it couldn't be created, also if it exists.
+bool create_directory(const char *path);
+
+// NOTE(llw): Renames from to to, replacing to if it exists. On posix,
+//  readers that opened or mapped the old file keep reading it.
+bool replace_file(const char *from, const char *to);
+
+U32 get_process_id();
+
 
 
 // Reader.
@@ -58,14 +81,43 @@ _inline Reader<U8> make_reader(String string) {
 
 using Interned_String = U32;
 
+// NOTE(llw): The hash is computed once per intern call and kept with the
+//  string, so growing the table never hashes the strings again. 32 bits of
+//  it keep the key as small as a String.
+struct String_Table_Key {
+    U8 *values;
+    U32 size;
+    U32 hash;
+};
+
+static_assert(sizeof(String_Table_Key) == sizeof(String), "");
+
+struct String_Table_Key_Hasher {
+    static U64 hash(const String_Table_Key &key) {
+        return key.hash;
+    }
+};
+
+namespace libcpp {
+    template <>
+    _inline bool eq(String_Table_Key left, String_Table_Key right) {
+        return left.hash == right.hash
+            && left.size == right.size
+            && memcmp(left.values, right.values, left.size) == 0;
+    }
+}
+
 struct String_Table {
     Allocator *allocator;
-    Map<String, Interned_String> table;
-    Map<Interned_String, String> reverse;
+    // NOTE(llw): The null terminated bytes of the strings, back to back.
+    Arena storage;
+    Map<String_Table_Key, Interned_String, String_Table_Key_Hasher> table;
+    // NOTE(llw): Indexed by id, strings[0] is the empty string for "none".
+    Array<String> strings;
     Interned_String previous_id;
 
     String operator[](Interned_String key) const {
-        return reverse[key];
+        return strings[key];
     }
 };
 
@@ -128,3 +180,11 @@ U64 parse_int(String string);
 void serialize_int(U64 value, Array<U8> &buffer);
 void push_int(Array<U8> &buffer, U64 value);
 
+
+//
+// RANGE time.
+//
+
+// NOTE(llw): Monotonic, in nanoseconds. Only differences are meaningful.
+U64 get_time_ns();
+
@@ -0,0 +1,661 @@
+#include <libcpp/util/defer.hpp>
+#include <libcpp/util/math.hpp>
+
+#include <libcpp/memory/arena.hpp>
+#include <libcpp/memory/array.hpp>
+#include <libcpp/memory/map.hpp>
+#include <libcpp/memory/set.hpp>
+#include <libcpp/memory/heap.hpp>
+
+
+using namespace libcpp;
+
+#pragma warning(push, 0)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#pragma warning(pop)
+
+
+//
+// RANGE harness.
+//
+
+// NOTE(llw): Results are folded into this so the work can't be optimized out.
+static volatile U64 sink;
+
+static Usize run_count = 5;
+
+static U64 get_time_ns() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (U64)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+// NOTE(llw): Best of run_count, in ns per operation.
+template <typename F>
+F64 measure(Usize operations, F f) {
+    auto best = (U64)-1;
+    for(Usize run = 0; run < run_count; run += 1) {
+        auto begin = get_time_ns();
+        sink = sink + f();
+        best = min(best, get_time_ns() - begin);
+    }
+    return (F64)best / (F64)operations;
+}
+
+static void print_header(const char *title) {
+    printf("\n--- %s ---\n", title);
+    printf("%-32s %12s %12s %8s\n", "", "libcpp ns/op", "std ns/op", "ratio");
+}
+
+static void print_result(const char *name, F64 libcpp_ns, F64 std_ns) {
+    printf("%-32s %12.2f %12.2f %8.2f\n", name, libcpp_ns, std_ns, libcpp_ns / std_ns);
+}
+
+
+// NOTE(llw): xorshift64, deterministic across runs.
+struct Random {
+    U64 state;
+};
+
+static U64 next(Random &random) {
+    auto x = random.state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    random.state = x;
+    return x;
+}
+
+static std::vector<U32> make_u32_keys(Usize count) {
+    auto random = Random { 0x9e3779b97f4a7c15ull };
+    auto result = std::vector<U32>(count);
+    for(Usize i = 0; i < count; i += 1) {
+        result[i] = (U32)next(random);
+    }
+    return result;
+}
+
+// NOTE(llw): Identifier-like keys, the compiler's main String key.
+static std::vector<U8> make_string_storage(Usize count, Usize key_size) {
+    auto random = Random { 0x2545f4914f6cdd1dull };
+    auto result = std::vector<U8>(count*key_size);
+    for(Usize i = 0; i < result.size(); i += 1) {
+        result[i] = (U8)('a' + next(random) % 26);
+    }
+    return result;
+}
+
+
+//
+// RANGE array.
+//
+
+static void bench_array(Usize n) {
+    print_header("Array vs std::vector");
+
+    {
+        auto libcpp_ns = measure(n, [&]() {
+            auto array = create_array<U32>();
+            defer { destroy(array); };
+            for(Usize i = 0; i < n; i += 1) {
+                push(array, (U32)i);
+            }
+            return (U64)array.count;
+        });
+
+        auto std_ns = measure(n, [&]() {
+            auto vector = std::vector<U32>();
+            for(Usize i = 0; i < n; i += 1) {
+                vector.push_back((U32)i);
+            }
+            return (U64)vector.size();
+        });
+
+        print_result("push", libcpp_ns, std_ns);
+    }
+
+    // NOTE(llw): Quadratic, so fewer elements.
+    auto m = min(n, (Usize)10000);
+
+    {
+        auto libcpp_ns = measure(m, [&]() {
+            auto array = create_array<U32>();
+            defer { destroy(array); };
+            for(Usize i = 0; i < m; i += 1) {
+                push_front(array, (U32)i);
+            }
+            return (U64)array[0];
+        });
+
+        auto std_ns = measure(m, [&]() {
+            auto vector = std::vector<U32>();
+            for(Usize i = 0; i < m; i += 1) {
+                vector.insert(vector.begin(), (U32)i);
+            }
+            return (U64)vector[0];
+        });
+
+        print_result("push_front", libcpp_ns, std_ns);
+    }
+
+    {
+        auto libcpp_ns = measure(m, [&]() {
+            auto array = create_array<U32>();
+            defer { destroy(array); };
+            for(Usize i = 0; i < m; i += 1) {
+                make_space_at(array, array.count/2, 4);
+            }
+            return (U64)array.count;
+        });
+
+        auto std_ns = measure(m, [&]() {
+            auto vector = std::vector<U32>();
+            for(Usize i = 0; i < m; i += 1) {
+                vector.insert(vector.begin() + vector.size()/2, 4, 0);
+            }
+            return (U64)vector.size();
+        });
+
+        print_result("make_space_at (middle, 4)", libcpp_ns, std_ns);
+    }
+}
+
+
+//
+// RANGE map, set.
+//
+
+static void bench_map_u32(Usize n) {
+    print_header("Map<U32> vs std::unordered_map");
+
+    auto keys = make_u32_keys(n);
+
+    auto map = create_map<U32, U32>();
+    defer { destroy(map); };
+    auto std_map = std::unordered_map<U32, U32>();
+
+    auto insert_ns = measure(n, [&]() {
+        destroy(map);
+        map = create_map<U32, U32>();
+        for(Usize i = 0; i < n; i += 1) {
+            insert_or_set(map, keys[i], (U32)i);
+        }
+        return (U64)map.count;
+    });
+    auto std_insert_ns = measure(n, [&]() {
+        std_map = {};
+        for(Usize i = 0; i < n; i += 1) {
+            std_map[keys[i]] = (U32)i;
+        }
+        return (U64)std_map.size();
+    });
+    print_result("insert", insert_ns, std_insert_ns);
+
+    auto lookup_ns = measure(n, [&]() {
+        auto result = (U64)0;
+        for(Usize i = 0; i < n; i += 1) {
+            result += *get_pointer(map, keys[i]);
+        }
+        return result;
+    });
+    auto std_lookup_ns = measure(n, [&]() {
+        auto result = (U64)0;
+        for(Usize i = 0; i < n; i += 1) {
+            result += std_map.find(keys[i])->second;
+        }
+        return result;
+    });
+    print_result("lookup (hit)", lookup_ns, std_lookup_ns);
+
+    auto miss_ns = measure(n, [&]() {
+        auto result = (U64)0;
+        for(Usize i = 0; i < n; i += 1) {
+            result += has(map, keys[i] ^ 0x5bd1e995u);
+        }
+        return result;
+    });
+    auto std_miss_ns = measure(n, [&]() {
+        auto result = (U64)0;
+        for(Usize i = 0; i < n; i += 1) {
+            result += std_map.count(keys[i] ^ 0x5bd1e995u);
+        }
+        return result;
+    });
+    print_result("lookup (miss)", miss_ns, std_miss_ns);
+
+    // NOTE(llw): Removal is destructive, so refill before each run. The fill
+    //  is included in both numbers.
+    auto remove_ns = measure(n, [&]() {
+        for(Usize i = 0; i < n; i += 1) {
+            insert_or_set(map, keys[i], (U32)i);
+        }
+        for(Usize i = 0; i < n; i += 1) {
+            remove_maybe(map, keys[i]);
+        }
+        return (U64)map.count;
+    });
+    auto std_remove_ns = measure(n, [&]() {
+        for(Usize i = 0; i < n; i += 1) {
+            std_map[keys[i]] = (U32)i;
+        }
+        for(Usize i = 0; i < n; i += 1) {
+            std_map.erase(keys[i]);
+        }
+        return (U64)std_map.size();
+    });
+    print_result("insert + remove", remove_ns, std_remove_ns);
+}
+
+static void bench_map_string(Usize n, Usize key_size) {
+    char title[64];
+    snprintf(title, sizeof(title), "Map<String> vs std::unordered_map (%zu byte keys)", key_size);
+    print_header(title);
+
+    auto storage = make_string_storage(n, key_size);
+    auto get_key = [&](Usize i) {
+        return String { storage.data() + i*key_size, key_size };
+    };
+    auto get_std_key = [&](Usize i) {
+        return std::string_view((const char *)storage.data() + i*key_size, key_size);
+    };
+
+    auto map = create_map<String, U32>();
+    defer { destroy(map); };
+    auto std_map = std::unordered_map<std::string_view, U32>();
+
+    auto insert_ns = measure(n, [&]() {
+        destroy(map);
+        map = create_map<String, U32>();
+        for(Usize i = 0; i < n; i += 1) {
+            insert_or_set(map, get_key(i), (U32)i);
+        }
+        return (U64)map.count;
+    });
+    auto std_insert_ns = measure(n, [&]() {
+        std_map = {};
+        for(Usize i = 0; i < n; i += 1) {
+            std_map[get_std_key(i)] = (U32)i;
+        }
+        return (U64)std_map.size();
+    });
+    print_result("insert", insert_ns, std_insert_ns);
+
+    auto lookup_ns = measure(n, [&]() {
+        auto result = (U64)0;
+        for(Usize i = 0; i < n; i += 1) {
+            result += *get_pointer(map, get_key(i));
+        }
+        return result;
+    });
+    auto std_lookup_ns = measure(n, [&]() {
+        auto result = (U64)0;
+        for(Usize i = 0; i < n; i += 1) {
+            result += std_map.find(get_std_key(i))->second;
+        }
+        return result;
+    });
+    print_result("lookup (hit)", lookup_ns, std_lookup_ns);
+
+    auto remove_ns = measure(n, [&]() {
+        for(Usize i = 0; i < n; i += 1) {
+            insert_or_set(map, get_key(i), (U32)i);
+        }
+        for(Usize i = 0; i < n; i += 1) {
+            remove_maybe(map, get_key(i));
+        }
+        return (U64)map.count;
+    });
+    auto std_remove_ns = measure(n, [&]() {
+        for(Usize i = 0; i < n; i += 1) {
+            std_map[get_std_key(i)] = (U32)i;
+        }
+        for(Usize i = 0; i < n; i += 1) {
+            std_map.erase(get_std_key(i));
+        }
+        return (U64)std_map.size();
+    });
+    print_result("insert + remove", remove_ns, std_remove_ns);
+}
+
+static void bench_set_u32(Usize n) {
+    print_header("Set<U32> vs std::unordered_set");
+
+    auto keys = make_u32_keys(n);
+
+    auto set = create_set<U32>();
+    defer { destroy(set); };
+    auto std_set = std::unordered_set<U32>();
+
+    auto insert_ns = measure(n, [&]() {
+        destroy(set);
+        set = create_set<U32>();
+        for(Usize i = 0; i < n; i += 1) {
+            insert_maybe(set, keys[i]);
+        }
+        return (U64)set.count;
+    });
+    auto std_insert_ns = measure(n, [&]() {
+        std_set = {};
+        for(Usize i = 0; i < n; i += 1) {
+            std_set.insert(keys[i]);
+        }
+        return (U64)std_set.size();
+    });
+    print_result("insert", insert_ns, std_insert_ns);
+
+    auto lookup_ns = measure(n, [&]() {
+        auto result = (U64)0;
+        for(Usize i = 0; i < n; i += 1) {
+            result += has(set, keys[i]);
+        }
+        return result;
+    });
+    auto std_lookup_ns = measure(n, [&]() {
+        auto result = (U64)0;
+        for(Usize i = 0; i < n; i += 1) {
+            result += std_set.count(keys[i]);
+        }
+        return result;
+    });
+    print_result("lookup (hit)", lookup_ns, std_lookup_ns);
+
+    auto remove_ns = measure(n, [&]() {
+        for(Usize i = 0; i < n; i += 1) {
+            insert_maybe(set, keys[i]);
+        }
+        for(Usize i = 0; i < n; i += 1) {
+            remove_maybe(set, keys[i]);
+        }
+        return (U64)set.count;
+    });
+    auto std_remove_ns = measure(n, [&]() {
+        for(Usize i = 0; i < n; i += 1) {
+            std_set.insert(keys[i]);
+        }
+        for(Usize i = 0; i < n; i += 1) {
+            std_set.erase(keys[i]);
+        }
+        return (U64)std_set.size();
+    });
+    print_result("insert + remove", remove_ns, std_remove_ns);
+}
+
+
+//
+// RANGE hash.
+//
+
+static void bench_hash(Usize n) {
+    printf("\n--- murmur_hash_64 vs std::hash<std::string_view> ---\n");
+    printf("%-32s %12s %12s %8s\n", "", "libcpp GB/s", "std GB/s", "ratio");
+
+    Usize sizes[] = { 4, 8, 16, 32, 64, 256, 4096 };
+
+    for(auto size : sizes) {
+        // NOTE(llw): Roughly the same number of bytes per size.
+        auto key_count = max((Usize)16, n*16 / size);
+        auto storage = make_string_storage(key_count, size);
+
+        auto libcpp_ns = measure(key_count, [&]() {
+            auto result = (U64)0;
+            for(Usize i = 0; i < key_count; i += 1) {
+                result ^= murmur_hash_64(storage.data() + i*size, size);
+            }
+            return result;
+        });
+
+        auto std_ns = measure(key_count, [&]() {
+            auto hasher = std::hash<std::string_view>();
+            auto result = (U64)0;
+            for(Usize i = 0; i < key_count; i += 1) {
+                result ^= (U64)hasher(std::string_view((const char *)storage.data() + i*size, size));
+            }
+            return result;
+        });
+
+        char name[32];
+        snprintf(name, sizeof(name), "%zu bytes", size);
+
+        // NOTE(llw): bytes per ns = GB/s.
+        auto libcpp_rate = (F64)size / libcpp_ns;
+        auto std_rate = (F64)size / std_ns;
+        printf("%-32s %12.2f %12.2f %8.2f\n", name, libcpp_rate, std_rate, libcpp_rate / std_rate);
+    }
+}
+
+
+//
+// RANGE allocators.
+//
+
+static void bench_allocators(Usize n) {
+    print_header("Arena, Heap vs malloc");
+
+    auto random = Random { 0xda942042e4dd58b5ull };
+    auto sizes = std::vector<Usize>(n);
+    for(Usize i = 0; i < n; i += 1) {
+        sizes[i] = 8 + next(random) % 249;
+    }
+
+    // NOTE(llw): Free order for the random free pattern.
+    auto order = std::vector<Usize>(n);
+    for(Usize i = 0; i < n; i += 1) {
+        order[i] = i;
+    }
+    for(Usize i = n; i > 1; i -= 1) {
+        auto j = next(random) % i;
+        auto temp = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = temp;
+    }
+
+    auto pointers = std::vector<void *>(n);
+
+    // NOTE(llw): Arena: allocate everything, then reset. malloc: allocate
+    //  everything, then free everything.
+    {
+        auto arena = create_arena();
+        defer { destroy(arena); };
+        auto state = get_state(arena);
+
+        auto arena_ns = measure(n, [&]() {
+            auto result = (U64)0;
+            for(Usize i = 0; i < n; i += 1) {
+                auto pointer = (U8 *)allocate_uninitialized(sizes[i], 8, arena);
+                pointer[0] = (U8)i;
+                result += pointer[0];
+            }
+            reset(arena, state);
+            return result;
+        });
+
+        auto malloc_ns = measure(n, [&]() {
+            auto result = (U64)0;
+            for(Usize i = 0; i < n; i += 1) {
+                auto pointer = (U8 *)std::malloc(sizes[i]);
+                pointer[0] = (U8)i;
+                result += pointer[0];
+                pointers[i] = pointer;
+            }
+            for(Usize i = 0; i < n; i += 1) {
+                std::free(pointers[i]);
+            }
+            return result;
+        });
+
+        print_result("arena allocate + reset", arena_ns, malloc_ns);
+
+        auto virtual_arena = create_virtual_arena();
+        defer { destroy(virtual_arena); };
+        auto virtual_state = get_state(virtual_arena);
+
+        auto virtual_arena_ns = measure(n, [&]() {
+            auto result = (U64)0;
+            for(Usize i = 0; i < n; i += 1) {
+                auto pointer = (U8 *)allocate_uninitialized(sizes[i], 8, virtual_arena);
+                pointer[0] = (U8)i;
+                result += pointer[0];
+            }
+            reset(virtual_arena, virtual_state);
+            return result;
+        });
+
+        print_result("virtual arena allocate + reset", virtual_arena_ns, malloc_ns);
+    }
+
+    // NOTE(llw): One growing buffer on top of an arena, like the codegen
+    //  output buffers.
+    {
+        auto arena = create_arena();
+        defer { destroy(arena); };
+        auto virtual_arena = create_virtual_arena();
+        defer { destroy(virtual_arena); };
+
+        auto push_bytes = [&](Allocator &allocator) {
+            auto array = create_array<U8>(allocator);
+            for(Usize i = 0; i < n*64; i += 1) {
+                push(array, (U8)i);
+            }
+            return (U64)array.count;
+        };
+
+        auto arena_ns = measure(n*64, [&]() {
+            auto state = get_state(arena);
+            auto result = push_bytes(arena);
+            reset(arena, state);
+            return result;
+        });
+
+        auto virtual_arena_ns = measure(n*64, [&]() {
+            auto state = get_state(virtual_arena);
+            auto result = push_bytes(virtual_arena);
+            reset(virtual_arena, state);
+            return result;
+        });
+
+        auto vector_ns = measure(n*64, [&]() {
+            auto vector = std::vector<U8>();
+            for(Usize i = 0; i < n*64; i += 1) {
+                vector.push_back((U8)i);
+            }
+            return (U64)vector.size();
+        });
+
+        print_result("array push bytes (arena)", arena_ns, vector_ns);
+        print_result("array push bytes (virtual arena)", virtual_arena_ns, vector_ns);
+    }
+
+    // NOTE(llw): Heap: allocate everything, then free in random order.
+    {
+        auto heap = create_heap();
+        defer { destroy(heap); };
+
+        // NOTE(llw): Quadratic-ish in live chunk count, so fewer elements.
+        auto m = min(n, (Usize)20000);
+
+        auto heap_ns = measure(m, [&]() {
+            auto result = (U64)0;
+            for(Usize i = 0; i < m; i += 1) {
+                auto pointer = (U8 *)allocate_uninitialized(sizes[i], 8, heap);
+                pointer[0] = (U8)i;
+                result += pointer[0];
+                pointers[i] = pointer;
+            }
+            for(Usize i = 0; i < n; i += 1) {
+                if(order[i] < m) {
+                    heap_free(&heap, pointers[order[i]]);
+                }
+            }
+            return result;
+        });
+
+        auto malloc_ns = measure(m, [&]() {
+            auto result = (U64)0;
+            for(Usize i = 0; i < m; i += 1) {
+                auto pointer = (U8 *)std::malloc(sizes[i]);
+                pointer[0] = (U8)i;
+                result += pointer[0];
+                pointers[i] = pointer;
+            }
+            for(Usize i = 0; i < n; i += 1) {
+                if(order[i] < m) {
+                    std::free(pointers[order[i]]);
+                }
+            }
+            return result;
+        });
+
+        print_result("heap allocate + random free", heap_ns, malloc_ns);
+
+        // NOTE(llw): Interleaved: keep a window of live allocations.
+        constexpr Usize window = 64;
+
+        auto heap_window_ns = measure(n, [&]() {
+            void *live[window] = {};
+            for(Usize i = 0; i < n; i += 1) {
+                auto slot = order[i] % window;
+                if(live[slot] != NULL) {
+                    heap_free(&heap, live[slot]);
+                }
+                live[slot] = allocate_uninitialized(sizes[i], 8, heap);
+            }
+            for(Usize i = 0; i < window; i += 1) {
+                if(live[i] != NULL) {
+                    heap_free(&heap, live[i]);
+                }
+            }
+            return (U64)0;
+        });
+
+        auto malloc_window_ns = measure(n, [&]() {
+            void *live[window] = {};
+            for(Usize i = 0; i < n; i += 1) {
+                auto slot = order[i] % window;
+                std::free(live[slot]);
+                live[slot] = std::malloc(sizes[i]);
+            }
+            for(Usize i = 0; i < window; i += 1) {
+                std::free(live[i]);
+            }
+            return (U64)0;
+        });
+
+        print_result("heap churn (64 live)", heap_window_ns, malloc_window_ns);
+    }
+}
+
+
+int main(int argument_count, const char **arguments) {
+    auto n = (Usize)100000;
+
+    for(int i = 1; i < argument_count; i += 1) {
+        if(strcmp(arguments[i], "-n") == 0 && i + 1 < argument_count) {
+            i += 1;
+            n = (Usize)atoll(arguments[i]);
+        }
+        else if(strcmp(arguments[i], "-runs") == 0 && i + 1 < argument_count) {
+            i += 1;
+            run_count = max((Usize)1, (Usize)atoll(arguments[i]));
+        }
+        else {
+            printf("Usage: benchmarks [-n operations] [-runs count]\n");
+            return 1;
+        }
+    }
+
+    printf("n = %zu, best of %zu runs\n", n, run_count);
+
+    bench_array(n);
+    bench_map_u32(n);
+    bench_map_string(n, 8);
+    bench_map_string(n, 32);
+    bench_set_u32(n);
+    bench_hash(n);
+    bench_allocators(n);
+}
@@ -0,0 +1,4 @@
+// NOTE(llw): Same settings as the compiler, so the numbers carry over.
+#define LIBCPP_ENABLE_ASSERT 1
+#define DLIBCPP_USE_LIBC 1
+
@@ -34,11 +34,16 @@ set LIBCPP_SOURCES=^
     %LIBCPP_ROOT%\libcpp\memory\arena.cpp^
     %LIBCPP_ROOT%\libcpp\memory\hash.cpp^
     %LIBCPP_ROOT%\libcpp\memory\heap.cpp^
+    %LIBCPP_ROOT%\libcpp\memory\tracking.cpp^
+    %LIBCPP_ROOT%\libcpp\memory\virtual_memory_win32.cpp^
     %LIBCPP_ROOT%\libcpp\util\assert.cpp^
-    %LIBCPP_ROOT%\libcpp\util\assert_win32.cpp
+    %LIBCPP_ROOT%\libcpp\util\assert_win32.cpp^
+    %LIBCPP_ROOT%\libcpp\util\thread_win32.cpp
 
 set libcpp=/I%LIBCPP_ROOT%
 
 cl ..\examples\examples.cpp %LIBCPP_SOURCES% User32.lib /I..\examples %libcpp% %compile_flags_debug% /link %link_flags% /out:main.exe
 
+cl ..\benchmarks\benchmarks.cpp %LIBCPP_SOURCES% User32.lib /I..\benchmarks %libcpp% %compile_flags_release% /link %link_flags% /out:benchmarks.exe
+
 popd
@@ -18,6 +18,22 @@
 #define LIBCPP_ARENA_DEFAULT_BLOCK_SIZE MEBI(16)
 #endif
 
+#ifndef LIBCPP_VIRTUAL_ARENA_DEFAULT_RESERVE
+#define LIBCPP_VIRTUAL_ARENA_DEFAULT_RESERVE GIBI(64)
+#endif
+
+// NOTE(llw): Must be a multiple of the page size (and of the allocation
+//  granularity on windows).
+#ifndef LIBCPP_VIRTUAL_ARENA_COMMIT_SIZE
+#define LIBCPP_VIRTUAL_ARENA_COMMIT_SIZE KIBI(64)
+#endif
+
+// NOTE(llw): reset only decommits if at least this much would be freed, so
+//  short TEMP_SCOPEs don't cause syscalls.
+#ifndef LIBCPP_VIRTUAL_ARENA_DECOMMIT_THRESHOLD
+#define LIBCPP_VIRTUAL_ARENA_DECOMMIT_THRESHOLD MEBI(4)
+#endif
+
 #ifndef LIBCPP_HEAP_DEFAULT_BLOCK_SIZE
 #define LIBCPP_HEAP_DEFAULT_BLOCK_SIZE MEBI(8)
 #endif
@@ -28,7 +28,7 @@ static void malloc_free(Allocator *data, void *allocation) {
 
 namespace libcpp {
 
-    Allocator malloc_allocator = { malloc_allocate, malloc_free };
+    Allocator malloc_allocator = { malloc_allocate, malloc_free, NULL };
 
     Allocator &default_allocator = malloc_allocator;
 
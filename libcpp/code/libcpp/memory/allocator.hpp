@@ -12,9 +12,15 @@ namespace libcpp {
     struct Allocator {
         typedef void *(Proc_allocate)(Allocator *data, Usize size, Usize alignment);
         typedef void  (Proc_free    )(Allocator *data, void *allocation);
+        typedef bool  (Proc_resize  )(Allocator *data, void *allocation, Usize old_size, Usize new_size);
 
         Proc_allocate *allocate;
         Proc_free     *free;
+
+        // NOTE(llw): Optional, may be NULL. Resizes the allocation in place,
+        //  returns false if that isn't possible. The allocation is unchanged
+        //  in that case.
+        Proc_resize   *resize;
     };
 
     extern Allocator &default_allocator;
@@ -33,6 +39,18 @@ namespace libcpp {
         return result;
     }
 
+    _inline bool try_resize(
+        void *allocation, Usize old_size, Usize new_size,
+        Allocator &allocator = default_allocator
+    ) {
+        if(allocator.resize == NULL) {
+            return false;
+        }
+
+        auto result = allocator.resize(&allocator, allocation, old_size, new_size);
+        return result;
+    }
+
     template <typename T>
     _inline void free(
         T *&allocation,
@@ -86,6 +104,18 @@ namespace libcpp {
         return result;
     }
 
+    template <typename T>
+    _inline bool try_resize_array(
+        T *allocation, Usize old_count, Usize new_count,
+        Allocator &allocator = default_allocator
+    ) {
+        auto result = try_resize(
+            (void *)allocation, old_count*sizeof(T), new_count*sizeof(T),
+            allocator
+        );
+        return result;
+    }
+
     template <typename T>
     _inline T *allocate_array(
         Usize count,
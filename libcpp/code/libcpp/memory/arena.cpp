@@ -1,4 +1,5 @@
 #include <libcpp/memory/arena.hpp>
+#include <libcpp/memory/virtual_memory.hpp>
 #include <libcpp/util/math.hpp>
 
 namespace libcpp {
@@ -13,13 +14,37 @@ namespace libcpp {
         auto result = Arena {};
         result.allocate   = arena_allocate;
         result.free       = arena_free;
+        result.resize     = arena_resize;
         result.allocator  = &backing;
         result.block_size = block_size;
 
         return result;
     }
 
+    Arena create_virtual_arena(Usize reserve_size) {
+        assert(LIBCPP_VIRTUAL_ARENA_COMMIT_SIZE % get_page_size() == 0);
+
+        reserve_size += alignment_offset(reserve_size, LIBCPP_VIRTUAL_ARENA_COMMIT_SIZE);
+
+        auto result = Arena {};
+        result.allocate   = virtual_arena_allocate;
+        result.free       = arena_free;
+        result.resize     = virtual_arena_resize;
+        result.base       = reserve_virtual_memory(reserve_size);
+        result.capacity   = reserve_size;
+        result.is_virtual = true;
+        assert(result.base != NULL);
+
+        return result;
+    }
+
     void destroy(Arena &arena) {
+        if(arena.is_virtual) {
+            release_virtual_memory(arena.base, arena.capacity);
+            arena = {};
+            return;
+        }
+
         remove_extra_allocations(arena);
 
         if(arena.base != NULL) {
@@ -100,6 +125,107 @@ namespace libcpp {
         UNUSED(allocation);
     }
 
+    bool arena_resize(Allocator *data, void *allocation, Usize old_size, Usize new_size) {
+        assert(new_size > 0);
+
+        auto &arena = *(Arena *)data;
+
+        auto begin = (Usize)allocation - (Usize)arena.base;
+        auto is_last =
+               arena.base != NULL
+            && (Usize)allocation >= (Usize)arena.base
+            && begin + old_size == arena.used;
+
+        if(is_last) {
+            if(begin + new_size > arena.capacity) {
+                return false;
+            }
+
+            arena.used = begin + new_size;
+            return true;
+        }
+
+        // NOTE(llw): Not the last allocation, the tail is wasted.
+        return new_size <= old_size;
+    }
+
+
+    //
+    // RANGE virtual allocate.
+    //
+
+    static bool commit_until(Arena &arena, Usize used) {
+        if(used <= arena.committed) {
+            return true;
+        }
+
+        if(used > arena.capacity) {
+            return false;
+        }
+
+        auto new_committed = used + alignment_offset(used, LIBCPP_VIRTUAL_ARENA_COMMIT_SIZE);
+        new_committed = min(new_committed, arena.capacity);
+
+        auto committed = commit_virtual_memory(
+            (U8 *)arena.base + arena.committed,
+            new_committed - arena.committed
+        );
+        if(!committed) {
+            return false;
+        }
+
+        arena.committed = new_committed;
+        return true;
+    }
+
+    static void decommit_after(Arena &arena, Usize used) {
+        auto keep = used + alignment_offset(used, LIBCPP_VIRTUAL_ARENA_COMMIT_SIZE);
+
+        if(arena.committed > keep
+            && arena.committed - keep >= LIBCPP_VIRTUAL_ARENA_DECOMMIT_THRESHOLD
+        ) {
+            decommit_virtual_memory((U8 *)arena.base + keep, arena.committed - keep);
+            arena.committed = keep;
+        }
+    }
+
+    void *virtual_arena_allocate(Allocator *data, Usize size, Usize alignment) {
+        assert(size > 0);
+        assert(is_power_of_two(alignment));
+
+        auto &arena = *(Arena *)data;
+
+        auto offset = alignment_offset((Usize)arena.base + arena.used, alignment);
+        auto new_used = arena.used + offset + size;
+
+        // NOTE(llw): Out of reserved address space (or memory). The pointer
+        //  would be into uncommitted memory, so this is always checked.
+        auto committed = commit_until(arena, new_used);
+        always_assert(committed);
+
+        auto allocation = (void *)((Usize)arena.base + arena.used + offset);
+        arena.used = new_used;
+        return allocation;
+    }
+
+    bool virtual_arena_resize(Allocator *data, void *allocation, Usize old_size, Usize new_size) {
+        assert(new_size > 0);
+
+        auto &arena = *(Arena *)data;
+
+        auto begin = (Usize)allocation - (Usize)arena.base;
+        if(begin + old_size == arena.used) {
+            if(!commit_until(arena, begin + new_size)) {
+                return false;
+            }
+
+            arena.used = begin + new_size;
+            return true;
+        }
+
+        return new_size <= old_size;
+    }
+
 
     //
     // RANGE reset.
@@ -126,6 +252,13 @@ namespace libcpp {
     }
 
     void reset(Arena &arena, Arena_State old_state) {
+        if(arena.is_virtual) {
+            assert(old_state.base == arena.base);
+            arena.used = old_state.used;
+            decommit_after(arena, arena.used);
+            return;
+        }
+
         auto used = max(old_state.used, sizeof(Arena_Marker));
         auto base = old_state.base;
 
@@ -136,5 +269,30 @@ namespace libcpp {
         arena.used = used;
     }
 
-}
 
+
+    //
+    // RANGE statistics.
+    //
+
+    Usize get_total_used(const Arena &arena) {
+        if(arena.base == NULL) {
+            return 0;
+        }
+
+        if(arena.is_virtual) {
+            return arena.used;
+        }
+
+        auto result = arena.used - sizeof(Arena_Marker);
+
+        auto marker = *(Arena_Marker *)arena.base;
+        while(marker.base != NULL) {
+            result += marker.capacity - sizeof(Arena_Marker);
+            marker = *(Arena_Marker *)marker.base;
+        }
+
+        return result;
+    }
+
+}
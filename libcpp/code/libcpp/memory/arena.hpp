@@ -12,16 +12,33 @@ namespace libcpp {
         Usize used;
         Usize capacity;
         Usize block_size;
+
+        // NOTE(llw): Virtual arenas reserve capacity bytes of address space at
+        //  base up front and never chain blocks. The first committed bytes
+        //  are backed by memory.
+        bool is_virtual;
+        Usize committed;
     };
 
     Arena create_arena(
         Allocator &backing = default_allocator,
         Usize block_size = LIBCPP_ARENA_DEFAULT_BLOCK_SIZE
     );
+    Arena create_virtual_arena(
+        Usize reserve_size = LIBCPP_VIRTUAL_ARENA_DEFAULT_RESERVE
+    );
     void destroy(Arena &arena);
 
     void *arena_allocate(Allocator *data, Usize size, Usize alignment);
     void arena_free(Allocator *data, void *allocation);
+    // NOTE(llw): Succeeds if the allocation is the most recent one and the
+    //  block has room, or if it shrinks.
+    bool arena_resize(Allocator *data, void *allocation, Usize old_size, Usize new_size);
+
+    // NOTE(llw): Resizing the last allocation only fails if the reserved
+    //  range is exhausted.
+    void *virtual_arena_allocate(Allocator *data, Usize size, Usize alignment);
+    bool virtual_arena_resize(Allocator *data, void *allocation, Usize old_size, Usize new_size);
 
     struct Arena_State {
         void *base;
@@ -34,6 +51,10 @@ namespace libcpp {
     }
     void reset(Arena &arena, Arena_State old_state);
 
+    // NOTE(llw): Bytes handed out since creation. Earlier blocks count as
+    //  fully used.
+    Usize get_total_used(const Arena &arena);
+
     #define TEMP_SCOPE(arena)                                               \
         auto __old_arena_state = get_state(arena);                          \
         defer { ::libcpp::reset((arena), __old_arena_state); }
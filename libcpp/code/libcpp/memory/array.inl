@@ -48,6 +48,14 @@ namespace libcpp {
     void set_capacity(Array<T> &array, Usize new_capacity) {
         assert(array.allocator != NULL);
 
+        // NOTE(llw): Avoids the copy, and the dead old buffer in arenas.
+        if(array.values != NULL && new_capacity > 0
+            && try_resize_array(array.values, array.capacity, new_capacity, *array.allocator)
+        ) {
+            array.capacity = new_capacity;
+            return;
+        }
+
         T *new_values = NULL;
         if(new_capacity > 0 && new_capacity != array.capacity) {
             new_values = allocate_array_uninitialized<T>(new_capacity, *array.allocator);
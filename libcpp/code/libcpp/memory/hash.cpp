@@ -2,6 +2,8 @@
 
 namespace libcpp {
 
+    volatile U64 hash_grow_count = 0;
+
     // NOTE(llw): Taken from
     // http://bitsquid.blogspot.com/2011/08/code-snippet-murmur-hash-inverse-pre.html.
     U64 murmur_hash_64(void *key, Usize size, U64 seed) {
@@ -3,11 +3,16 @@
 #include <libcpp/base.hpp>
 #include <libcpp/memory/allocator.hpp>
 #include <libcpp/memory/string.hpp>
+#include <libcpp/util/thread.hpp>
 
 namespace libcpp {
 
     U64 murmur_hash_64(void *key, Usize size, U64 seed = 0x0dc61362440d29b5ULL);
 
+    // NOTE(llw): Number of times any hash container reallocated its slots.
+    //  Only meant for statistics. Atomic, containers grow on any thread.
+    extern volatile U64 hash_grow_count;
+
     template <typename T>
     _inline U64 hash(const T &value) {
         auto result = murmur_hash_64((void *)&value, sizeof(value));
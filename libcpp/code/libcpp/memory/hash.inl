@@ -70,15 +70,41 @@ namespace libcpp { namespace _hash {
         assert(is_power_of_two(new_capacity));
 
         if(new_capacity > 0 && new_capacity != container.capacity) {
-            auto old_slots = container.slots;
-            auto old_entries = container.entries;
+            using Slot = typename Hash_Container<T, Hasher>::Slot;
+
+            auto &allocator = *container.allocator;
             auto old_capacity = container.capacity;
             auto old_count = container.count;
 
-            container.slots   = allocate_array<Hash_Container<T, Hasher>::Slot>(
-                new_capacity, *container.allocator
-            );
-            container.entries = allocate_array<T>(new_capacity, *container.allocator);
+            atomic_add(&hash_grow_count, 1);
+
+            // NOTE(llw): Try both in place before allocating anything, as only
+            //  the most recent allocation can grow in an arena. The slots are
+            //  rebuilt from the entries, so they don't need to be copied.
+            auto entries_resized = old_capacity > 0
+                && try_resize_array(container.entries, old_capacity, new_capacity, allocator);
+            auto slots_resized = old_capacity > 0
+                && try_resize_array(container.slots, old_capacity, new_capacity, allocator);
+
+            if(!entries_resized) {
+                auto new_entries = allocate_array<T>(new_capacity, allocator);
+                if(old_capacity > 0) {
+                    copy_values(new_entries, container.entries, min(old_count, new_capacity));
+                    free(container.entries, allocator);
+                }
+                container.entries = new_entries;
+            }
+
+            if(slots_resized) {
+                set_values(container.slots, Slot {}, new_capacity);
+            }
+            else {
+                if(old_capacity > 0) {
+                    free(container.slots, allocator);
+                }
+                container.slots = allocate_array<Slot>(new_capacity, allocator);
+            }
+
             container.count = 0;
             container.capacity = new_capacity;
 
@@ -86,18 +112,21 @@ namespace libcpp { namespace _hash {
                 i < old_count && !needs_grow(container);
                 i += 1
             ) {
-                _insert(container, old_entries[i]);
+                auto search_result = search(container, container.entries[i].key);
+                assert(search_result.found_slot == (Usize)-1);
+                assert(search_result.insertion_slot != (Usize)-1);
+
+                auto &slot = container.slots[search_result.insertion_slot];
+                slot.key = container.entries[i].key;
+                slot.entry_index = i;
+                slot.state = HASH_ENTRY_STATE_OCCUPIED;
+
+                container.count += 1;
             }
 
             if(new_capacity > old_capacity) {
                 assert(container.count == old_count);
             }
-
-            if(old_capacity > 0) {
-                assert(container.slots != NULL && container.entries != NULL);
-                free(old_entries, *container.allocator);
-                free(old_slots, *container.allocator);
-            }
         }
     }
 
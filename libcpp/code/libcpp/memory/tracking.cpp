@@ -0,0 +1,190 @@
+#include <libcpp/memory/tracking.hpp>
+#include <libcpp/util/math.hpp>
+
+namespace libcpp {
+
+    //
+    // RANGE registry.
+    //
+
+    // NOTE(llw): The target's procs are called with the target as data, so
+    //  the tracker has to be looked up by target.
+    static constexpr Usize tracking_registry_capacity = LIBCPP_TRACKING_MAX_TARGETS;
+    static Tracking_Allocator *tracking_registry[tracking_registry_capacity];
+
+    static Tracking_Allocator &find_tracker(Allocator *target) {
+        for(Usize i = 0; i < tracking_registry_capacity; i += 1) {
+            auto tracker = tracking_registry[i];
+            if(tracker != NULL && tracker->target == target) {
+                return *tracker;
+            }
+        }
+
+        assert(false);
+        return *tracking_registry[0];
+    }
+
+
+    //
+    // RANGE procs.
+    //
+
+    Usize get_histogram_bucket(Usize size) {
+        auto result = (Usize)0;
+        if(size > 16) {
+            // NOTE(llw): ceil(log2(size)) - 4.
+            result = (Usize)(64 - leading_zeros((U64)(size - 1))) - 4;
+        }
+        return min(result, (Usize)LIBCPP_TRACKING_HISTOGRAM_BUCKETS - 1);
+    }
+
+    Usize get_histogram_bucket_limit(Usize bucket) {
+        auto result = (Usize)16 << bucket;
+        return result;
+    }
+
+    static void record_allocation(Tracking_Statistics &statistics, Usize size, Usize waste) {
+        statistics.allocation_count += 1;
+        statistics.bytes_requested  += size;
+        statistics.alignment_waste  += waste;
+        statistics.live_bytes       += size;
+        statistics.peak_live_bytes   = max(statistics.peak_live_bytes, statistics.live_bytes);
+        statistics.histogram[get_histogram_bucket(size)] += 1;
+    }
+
+    static void record_free(Tracking_Statistics &statistics, Usize size) {
+        statistics.free_count  += 1;
+        statistics.bytes_freed += size;
+        statistics.live_bytes  -= size;
+    }
+
+    static void *tracking_allocate(Allocator *data, Usize size, Usize alignment) {
+        auto &tracker = find_tracker(data);
+
+        auto result = tracker.original.allocate(data, size, alignment);
+
+        // NOTE(llw): Padding between two consecutive allocations. Exact for
+        //  bump allocators, 0 for anything that doesn't allocate in order.
+        auto address = (Usize)result;
+        auto waste = (Usize)0;
+        if(address >= tracker.last_end && address - tracker.last_end < alignment) {
+            waste = address - tracker.last_end;
+        }
+        tracker.last_end = address + size;
+
+        auto allocation = Tracking_Allocator::Allocation { size, tracker.tag };
+        insert_or_set(tracker.allocations, address, allocation);
+
+        record_allocation(tracker.total, size, waste);
+        record_allocation(tracker.tags[tracker.tag], size, waste);
+
+        return result;
+    }
+
+    static void tracking_free(Allocator *data, void *pointer) {
+        auto &tracker = find_tracker(data);
+
+        auto allocation = get_pointer(tracker.allocations, (Usize)pointer);
+        if(allocation != NULL) {
+            record_free(tracker.total, allocation->size);
+            record_free(tracker.tags[allocation->tag], allocation->size);
+            remove(tracker.allocations, (Usize)pointer);
+        }
+
+        tracker.original.free(data, pointer);
+    }
+
+    static void record_resize(Tracking_Statistics &statistics, Usize old_size, Usize new_size) {
+        statistics.resize_count += 1;
+        if(new_size > old_size) {
+            statistics.bytes_requested += new_size - old_size;
+            statistics.live_bytes      += new_size - old_size;
+            statistics.peak_live_bytes  = max(statistics.peak_live_bytes, statistics.live_bytes);
+        }
+        else {
+            statistics.live_bytes -= old_size - new_size;
+        }
+    }
+
+    static bool tracking_resize(Allocator *data, void *pointer, Usize old_size, Usize new_size) {
+        auto &tracker = find_tracker(data);
+
+        if(!tracker.original.resize(data, pointer, old_size, new_size)) {
+            return false;
+        }
+
+        auto address = (Usize)pointer;
+        if(address + old_size == tracker.last_end) {
+            tracker.last_end = address + new_size;
+        }
+
+        auto allocation = get_pointer(tracker.allocations, address);
+        if(allocation != NULL) {
+            record_resize(tracker.total, allocation->size, new_size);
+            record_resize(tracker.tags[allocation->tag], allocation->size, new_size);
+            allocation->size = new_size;
+        }
+
+        return true;
+    }
+
+
+    //
+    // RANGE api.
+    //
+
+    Tracking_Allocator create_tracking_allocator(Allocator &side_table) {
+        auto result = Tracking_Allocator {};
+        result.allocations = create_map<Usize, Tracking_Allocator::Allocation>(side_table);
+        return result;
+    }
+
+    void destroy(Tracking_Allocator &tracker) {
+        if(tracker.target != NULL) {
+            uninstall(tracker);
+        }
+
+        _hash::destroy(tracker.allocations);
+        tracker = {};
+    }
+
+    bool install(Tracking_Allocator &tracker, Allocator &target) {
+        assert(tracker.target == NULL);
+        assert(target.allocate != tracking_allocate);
+        assert(tracker.allocations.allocator != &target);
+
+        for(Usize i = 0; i < tracking_registry_capacity; i += 1) {
+            if(tracking_registry[i] == NULL) {
+                tracking_registry[i] = &tracker;
+
+                tracker.target   = &target;
+                tracker.original = target;
+
+                target.allocate = tracking_allocate;
+                target.free     = tracking_free;
+                if(target.resize != NULL) {
+                    target.resize = tracking_resize;
+                }
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void uninstall(Tracking_Allocator &tracker) {
+        assert(tracker.target != NULL);
+
+        for(Usize i = 0; i < tracking_registry_capacity; i += 1) {
+            if(tracking_registry[i] == &tracker) {
+                tracking_registry[i] = NULL;
+            }
+        }
+
+        tracker.target->allocate = tracker.original.allocate;
+        tracker.target->free     = tracker.original.free;
+        tracker.target->resize   = tracker.original.resize;
+        tracker.target = NULL;
+    }
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <libcpp/base.hpp>
+#include <libcpp/memory/allocator.hpp>
+#include <libcpp/memory/map.hpp>
+#include <libcpp/util/defer.hpp>
+
+#ifndef LIBCPP_TRACKING_MAX_TAGS
+#define LIBCPP_TRACKING_MAX_TAGS 8
+#endif
+
+// NOTE(llw): How many trackers can be installed at the same time.
+#ifndef LIBCPP_TRACKING_MAX_TARGETS
+#define LIBCPP_TRACKING_MAX_TARGETS 16
+#endif
+
+#ifndef LIBCPP_TRACKING_HISTOGRAM_BUCKETS
+#define LIBCPP_TRACKING_HISTOGRAM_BUCKETS 16
+#endif
+
+namespace libcpp {
+
+    /* NOTE(llw): Tracking allocator.
+        - Interposes on an existing Allocator (Arena, Heap, malloc, ...) by
+          swapping its procs, so code holding a reference to the target
+          doesn't need to change.
+        - Allocations are forwarded unchanged. Sizes are kept in a side table
+          so the target's memory layout is the same as without tracking.
+        - Freed bytes are counted even if the target's free is a no-op (like
+          arena_free). For those, bytes_freed is dead memory.
+    */
+
+    struct Tracking_Statistics {
+        Usize allocation_count;
+        Usize free_count;
+        Usize resize_count;
+        Usize bytes_requested;
+        Usize bytes_freed;
+        Usize alignment_waste;
+        Usize live_bytes;
+        Usize peak_live_bytes;
+
+        // NOTE(llw): Bucket i counts sizes in (2^(i+3), 2^(i+4)], bucket 0
+        //  everything up to 16 bytes, the last one everything above.
+        Usize histogram[LIBCPP_TRACKING_HISTOGRAM_BUCKETS];
+    };
+
+    struct Tracking_Allocator {
+        struct Allocation {
+            Usize size;
+            Usize tag;
+        };
+
+        Allocator *target;
+        Allocator original;
+
+        Map<Usize, Allocation> allocations;
+        Usize last_end;
+
+        Usize tag;
+        Tracking_Statistics total;
+        Tracking_Statistics tags[LIBCPP_TRACKING_MAX_TAGS];
+    };
+
+    // NOTE(llw): side_table backs the size table, it must not be the target.
+    Tracking_Allocator create_tracking_allocator(
+        Allocator &side_table = default_allocator
+    );
+    void destroy(Tracking_Allocator &tracker);
+
+    // NOTE(llw): Returns false if LIBCPP_TRACKING_MAX_TARGETS trackers are
+    //  installed already. Installing and uninstalling must not race with
+    //  allocations through any tracked allocator.
+    bool install(Tracking_Allocator &tracker, Allocator &target);
+    void uninstall(Tracking_Allocator &tracker);
+
+    _inline Usize set_tag(Tracking_Allocator &tracker, Usize tag) {
+        assert(tag < LIBCPP_TRACKING_MAX_TAGS);
+        auto result = tracker.tag;
+        tracker.tag = tag;
+        return result;
+    }
+
+    Usize get_histogram_bucket(Usize size);
+    Usize get_histogram_bucket_limit(Usize bucket);
+
+    #define TRACKING_TAG_SCOPE(tracker, tag)                                \
+        auto LIBCPP_CONCAT(__old_tracking_tag_, __LINE__) =                 \
+            ::libcpp::set_tag((tracker), (tag));                            \
+        defer {                                                             \
+            ::libcpp::set_tag((tracker),                                    \
+                LIBCPP_CONCAT(__old_tracking_tag_, __LINE__));              \
+        }
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <libcpp/base.hpp>
+
+namespace libcpp {
+
+    // NOTE(llw): Platform specific, see virtual_memory_win32.cpp and
+    //  virtual_memory_posix.cpp. Addresses and sizes passed to commit,
+    //  decommit and release must be multiples of get_page_size().
+
+    Usize get_page_size();
+
+    // NOTE(llw): Reserves address space without backing it. Returns NULL on
+    //  failure.
+    void *reserve_virtual_memory(Usize size);
+    void release_virtual_memory(void *base, Usize size);
+
+    // NOTE(llw): Committed pages are zero initialized.
+    bool commit_virtual_memory(void *address, Usize size);
+    void decommit_virtual_memory(void *address, Usize size);
+
+}
@@ -0,0 +1,45 @@
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <libcpp/memory/virtual_memory.hpp>
+#include <libcpp/util/assert.hpp>
+
+namespace libcpp {
+
+    Usize get_page_size() {
+        return (Usize)sysconf(_SC_PAGESIZE);
+    }
+
+    void *reserve_virtual_memory(Usize size) {
+        auto result = mmap(
+            NULL, size,
+            PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+            -1, 0
+        );
+        if(result == MAP_FAILED) {
+            return NULL;
+        }
+        return result;
+    }
+
+    void release_virtual_memory(void *base, Usize size) {
+        auto error = munmap(base, size);
+        assert(error == 0);
+    }
+
+    bool commit_virtual_memory(void *address, Usize size) {
+        auto error = mprotect(address, size, PROT_READ | PROT_WRITE);
+        return error == 0;
+    }
+
+    void decommit_virtual_memory(void *address, Usize size) {
+        // NOTE(llw): Give the pages back, then make them inaccessible again.
+        //  MADV_DONTNEED on private anonymous memory zero fills on next use.
+        auto error = madvise(address, size, MADV_DONTNEED);
+        assert(error == 0);
+        error = mprotect(address, size, PROT_NONE);
+        assert(error == 0);
+    }
+
+}
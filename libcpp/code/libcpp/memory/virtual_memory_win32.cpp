@@ -0,0 +1,35 @@
+#include <Windows.h>
+
+#include <libcpp/memory/virtual_memory.hpp>
+#include <libcpp/util/assert.hpp>
+
+namespace libcpp {
+
+    Usize get_page_size() {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (Usize)info.dwPageSize;
+    }
+
+    void *reserve_virtual_memory(Usize size) {
+        auto result = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+        return result;
+    }
+
+    void release_virtual_memory(void *base, Usize size) {
+        UNUSED(size);
+        auto released = VirtualFree(base, 0, MEM_RELEASE);
+        assert(released);
+    }
+
+    bool commit_virtual_memory(void *address, Usize size) {
+        auto result = VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE);
+        return result != NULL;
+    }
+
+    void decommit_virtual_memory(void *address, Usize size) {
+        auto decommitted = VirtualFree(address, size, MEM_DECOMMIT);
+        assert(decommitted);
+    }
+
+}
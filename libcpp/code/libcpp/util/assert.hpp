@@ -36,6 +36,16 @@ namespace libcpp {
 
     #endif
 
+    // NOTE(llw): Checked even without LIBCPP_ENABLE_ASSERT, for failures the
+    //  caller can't recover from, like running out of memory.
+    #define always_assert(condition)                                        \
+        if(!(condition)) {                                                  \
+            _default_assert(                                                \
+                STRING(#condition),                                         \
+                STRING(__FILE__ ":" LIBCPP_STRINGIFY(__LINE__))             \
+            );                                                              \
+        }
+
     void push_assert(Proc_assert *proc_assert);
     void pop_assert();
 
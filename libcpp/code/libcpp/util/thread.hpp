@@ -0,0 +1,69 @@
+#pragma once
+
+#include <libcpp/base.hpp>
+#include <libcpp/util/defer.hpp>
+
+#if defined(LIBCPP_MSVC)
+    #include <intrin.h>
+#endif
+
+namespace libcpp {
+
+    // NOTE(llw): Platform specific, see thread_win32.cpp and
+    //  thread_posix.cpp.
+
+    typedef void (Thread_Proc)(void *data);
+
+    // NOTE(llw): Must stay at the same address until join_thread.
+    struct Thread {
+        U64 handle;
+        Thread_Proc *proc;
+        void *data;
+    };
+
+    bool create_thread(Thread &thread, Thread_Proc *proc, void *data);
+    void join_thread(Thread &thread);
+
+    // NOTE(llw): Logical processors, at least 1.
+    Usize get_processor_count();
+
+
+    // NOTE(llw): Not recursive. Must stay at the same address between
+    //  init_mutex and destroy_mutex.
+    struct Mutex {
+        alignas(8) U8 storage[64];
+    };
+
+    void init_mutex(Mutex &mutex);
+    void destroy_mutex(Mutex &mutex);
+    void lock(Mutex &mutex);
+    void unlock(Mutex &mutex);
+
+    #define LOCK_SCOPE(mutex)                                               \
+        lock(mutex);                                                        \
+        defer { unlock(mutex); }
+
+
+    //
+    // RANGE atomics.
+    //
+
+    // NOTE(llw): Sequentially consistent. Return the previous value.
+
+    _inline U32 atomic_add(volatile U32 *value, U32 amount) {
+    #if defined(LIBCPP_MSVC)
+        return (U32)_InterlockedExchangeAdd((volatile long *)value, (long)amount);
+    #else
+        return __atomic_fetch_add(value, amount, __ATOMIC_SEQ_CST);
+    #endif
+    }
+
+    _inline U64 atomic_add(volatile U64 *value, U64 amount) {
+    #if defined(LIBCPP_MSVC)
+        return (U64)_InterlockedExchangeAdd64((volatile long long *)value, (long long)amount);
+    #else
+        return __atomic_fetch_add(value, amount, __ATOMIC_SEQ_CST);
+    #endif
+    }
+
+}
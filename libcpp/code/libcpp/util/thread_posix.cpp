@@ -0,0 +1,64 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include <libcpp/util/thread.hpp>
+#include <libcpp/util/assert.hpp>
+
+namespace libcpp {
+
+    static_assert(sizeof(pthread_t) <= sizeof(U64), "");
+
+    static void *thread_entry(void *parameter) {
+        auto thread = (Thread *)parameter;
+        thread->proc(thread->data);
+        return NULL;
+    }
+
+    bool create_thread(Thread &thread, Thread_Proc *proc, void *data) {
+        thread = {};
+        thread.proc = proc;
+        thread.data = data;
+
+        auto handle = pthread_t {};
+        if(pthread_create(&handle, NULL, thread_entry, &thread) != 0) {
+            return false;
+        }
+
+        thread.handle = (U64)handle;
+        return true;
+    }
+
+    void join_thread(Thread &thread) {
+        auto error = pthread_join((pthread_t)thread.handle, NULL);
+        assert(error == 0);
+        thread = {};
+    }
+
+    Usize get_processor_count() {
+        auto count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (Usize)count : 1;
+    }
+
+    static_assert(sizeof(pthread_mutex_t) <= sizeof(Mutex::storage), "");
+
+    void init_mutex(Mutex &mutex) {
+        auto error = pthread_mutex_init((pthread_mutex_t *)mutex.storage, NULL);
+        assert(error == 0);
+    }
+
+    void destroy_mutex(Mutex &mutex) {
+        auto error = pthread_mutex_destroy((pthread_mutex_t *)mutex.storage);
+        assert(error == 0);
+    }
+
+    void lock(Mutex &mutex) {
+        auto error = pthread_mutex_lock((pthread_mutex_t *)mutex.storage);
+        assert(error == 0);
+    }
+
+    void unlock(Mutex &mutex) {
+        auto error = pthread_mutex_unlock((pthread_mutex_t *)mutex.storage);
+        assert(error == 0);
+    }
+
+}
@@ -0,0 +1,60 @@
+#include <Windows.h>
+
+#include <libcpp/util/thread.hpp>
+#include <libcpp/util/assert.hpp>
+
+namespace libcpp {
+
+    static DWORD WINAPI thread_entry(void *parameter) {
+        auto thread = (Thread *)parameter;
+        thread->proc(thread->data);
+        return 0;
+    }
+
+    bool create_thread(Thread &thread, Thread_Proc *proc, void *data) {
+        thread = {};
+        thread.proc = proc;
+        thread.data = data;
+
+        auto handle = CreateThread(NULL, 0, thread_entry, &thread, 0, NULL);
+        if(handle == NULL) {
+            return false;
+        }
+
+        thread.handle = (U64)handle;
+        return true;
+    }
+
+    void join_thread(Thread &thread) {
+        auto handle = (HANDLE)thread.handle;
+        auto result = WaitForSingleObject(handle, INFINITE);
+        assert(result == WAIT_OBJECT_0);
+        CloseHandle(handle);
+        thread = {};
+    }
+
+    Usize get_processor_count() {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? (Usize)info.dwNumberOfProcessors : 1;
+    }
+
+    static_assert(sizeof(SRWLOCK) <= sizeof(Mutex::storage), "");
+
+    void init_mutex(Mutex &mutex) {
+        InitializeSRWLock((SRWLOCK *)mutex.storage);
+    }
+
+    void destroy_mutex(Mutex &mutex) {
+        UNUSED(mutex);
+    }
+
+    void lock(Mutex &mutex) {
+        AcquireSRWLockExclusive((SRWLOCK *)mutex.storage);
+    }
+
+    void unlock(Mutex &mutex) {
+        ReleaseSRWLockExclusive((SRWLOCK *)mutex.storage);
+    }
+
+}